@@ -2,199 +2,334 @@
 #define BALLMANAGER_H
 
 #include <glm/glm.hpp>
-#include <glm/gtc/random.hpp>
 using namespace glm;
 #include <cstdlib>
-#include <ctime>
+#include <iostream>
 #include <vector>
 using namespace std;
-#include "model.h"
-#include "shader.h"
 #include "camera.h"
-
-// Bullet structure
-struct Bullet {
-	vec3 position;		// Bullet position
-	vec3 direction;		// Bullet flight direction
-	float speed;		// Bullet speed
-	float lifetime;		// Bullet lifetime
-	
-	// 动画相关
-	int currentFrameIndex; // 当前动画帧的索引 (0 到 N-1)
-	float frameTimer;      // 当前帧已显示的时间
-	float frameDuration;   // 每帧的持续时间 (例如，0.1秒)
-
-	Bullet(glm::vec3 pos, glm::vec3 dir, float spd = 100.0f, float frameDur = 0.1f) // 增加了默认子弹速度和帧持续时间
-		: position(pos), direction(glm::normalize(dir)), speed(spd), lifetime(5.0f),
-		currentFrameIndex(0), frameTimer(0.0f), frameDuration(frameDur) {}
-};
-
-float firerate=2.0f;
-// Enemy shooter structure (independent firing timer for each enemy)
-struct EnemyShooter {
-	vec3 enemyPosition;
-	float fireTimer;
-	float fireRate;
-	
-	EnemyShooter(vec3 pos, float rate ) 
-		: enemyPosition(pos), fireTimer(0.0f), fireRate(firerate) {}
-};
-
+#include "bulletgrid.h"
+#include "bulletstore.h"
+#include "entitystore.h"
+#include "eventbus.h"
+#include "hitscan.h"
+#include "jobsystem.h"
+#include "rng.h"
+#include "simconfig.h"
+#include "staticbvh.h"
+#include "timerwheel.h"
+
+const int BULLET_FRAME_COUNT = 5; // 子弹动画帧数 (dot1.obj - dot5.obj)
+const float BULLET_MAX_RANGE = 500.0f; // 子弹最大活动范围
+const size_t BULLET_CHUNK = 4096;   // Bullets per parallel chunk
+const float BULLET_HIT_RADIUS = 5.0f;  // Bullets this close to the player hit
+const float PLAYER_MAX_SPEED = 100.0f; // Above the player's walk plus jump speed, bounds hit checks
+const float BULLET_MUZZLE_HEIGHT = 2.0f; // Bullets start this far above the enemy, clear of the ground
+const float BULLET_SHOT_RADIUS = 7.0f; // Bullets this close to a player's shot are shot down
+
+// Wheel tick of a check that must run by `seconds`: one early, so rounding never makes it late
+inline unsigned long long HitCheckDue(double seconds) {
+	unsigned long long now = TimerNow(seconds);
+	return now > 0 ? now - 1 : 0;
+}
+
+// Bullet and enemy-shooter simulation. Each enemy in the EntityStore is a shooter with its
+// own fire timer, kept across spawns and kills. Bullets are evaluated in closed form
+// (BulletStore), so the per-tick work is the timers that come due: expiries, and hit
+// checks of the bullets that could have reached the player by now. A bullet's life ends
+// at the first wall of the room on its path, found when it is fired. GL-free; drawn by
+// BallRenderer.
 class BallManager {
 private:
-	glm::vec2 windowSize;
-
-	// Model* ball; // 不再是单个模型，而是一个模型数组
-	std::vector<Model*> bulletFrames; // 存储子弹的所有动画帧模型
 	int numBulletFrames;              // 子弹动画的总帧数
-
-	Shader* ballShader; // 子弹共用一个着色器
-	GLuint score;
-	// GLuint gameModel; // 如果游戏模式影响子弹行为，则保留
-	glm::vec3 lightPos;
-	glm::mat4 lightSpaceMatrix;
-
-	std::vector<Bullet> bullets;
-	std::vector<EnemyShooter> enemyShooters;
-
-	Camera* camera;
-	glm::mat4 model_matrix_temp; // 避免与 Model 类名冲突，并明确是临时变量
-	glm::mat4 projection;
-	glm::mat4 view;
+	float firerate;                   // First fire interval of new shooters, shrinks with score
+	float fireIntervalMin;            // Later intervals are min + [0, spread)
+	float fireIntervalSpread;
+	float fireIntervalScale;          // Every fire interval times this (SpawnDirector)
+
+	BulletStore bullets;              // Fixed capacity SoA, O(1) removal
+	TimerWheel<PoolHandle> expiries;  // Each bullet's end of life
+	TimerWheel<PoolHandle> hitChecks; // Each bullet's next player hit check
+	std::vector<PoolHandle> candidates; // Scratch for CheckBulletHitPlayer
+	BulletSweepBatch sweep;           // Ditto
+	size_t lastHitChecks;             // Bullets tested by the last CheckBulletHitPlayer
+	BulletGrid shotGrid;              // Bullets by cell, for CheckPlayerShooting...
+	std::vector<PoolHandle> shotHits; // ...and the ones its shots found
+	size_t lastShotChecks;            // Bullets tested by the last CheckPlayerShooting
+	size_t droppedBullets;            // Shots lost because the pool was full
+	EntityStore* shooters;            // Enemies; each one shoots
+	TimerWheel<EntityId> shotTimers;  // Each shooter's next shot
+	std::vector<EntityId> newShooters; // Scratch for UpdateShooters
+	std::vector<EntityId> dueShooters; // Scratch for UpdateEnemyShooting, with their due ticks...
+	std::vector<unsigned long long> dueTicks;
+	std::vector<float> shotRanges;     // ...and how far each shot flies, -1 when the player is out of sight
+	std::vector<EntityId> requestedShots; // From behavior scripts, fired by the next UpdateEnemyShooting
+	const StaticBVH* world;           // Walls stopping bullets, may be NULL
+	double clock;                     // Seconds simulated, the shot timers' time
+	float lastDeltaTime;              // Length of the last tick, for swept hits
+	vec3 lastPlayerPos;               // Player position at the previous hit check
+	unsigned long long seed;          // Run seed, for the shooters' fire intervals
+	unsigned long long tick;          // Updates so far, counter for the shooters' draws
+	JobSystem* jobs;                  // Splits the per-bullet loops, may be NULL
+	EventBus* events;                 // Player hits and bullets shot down go here, may be NULL
+
+	const Camera* camera;
 public:
-	BallManager(glm::vec2 windowSize, Camera* camera) {
-		this->windowSize = windowSize;
+	BallManager(const Camera* camera, EntityStore* shooters, unsigned long long seed, const SimConfig& config = SimConfig())
+		: bullets(config.maxBullets) {
 		this->camera = camera;
-		score = 0;
-		this->lightPos = glm::vec3(0.0, 400.0, 150.0);
-		glm::mat4 lightProjection = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, 1.0f, 500.0f);
-		glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
-		this->lightSpaceMatrix = lightProjection * lightView;
-
-		numBulletFrames = 0; // 初始化帧数
-		LoadModelsAndShader(); // 修改函数名，加载多个模型和着色器
-	}
-
-	~BallManager() { // 添加析构函数来释放模型资源
-		for (Model* frame : bulletFrames) {
-			delete frame;
-		}
-		bulletFrames.clear();
-		delete ballShader;
-	}
-	
-	// Update enemy shooter positions
-	void UpdateEnemyPositions(const vector<vec3>& enemyPositions) {
-		// Only recreate shooters if enemy count changes
-		if (enemyShooters.size() != enemyPositions.size()) {
-			enemyShooters.clear();
-			
-			// Create shooter for each enemy
-			for (const auto& pos : enemyPositions) {
-				// Each enemy has slightly different firing rate for randomness
-				float randomFireRate = 1.5f + (rand() % 200) / 100.0f; // 1.5-3.5 seconds
-				enemyShooters.push_back(EnemyShooter(pos, randomFireRate));
-			}
-		} else {
-			// Only update existing shooter positions
-			for (size_t i = 0; i < enemyPositions.size() && i < enemyShooters.size(); i++) {
-				enemyShooters[i].enemyPosition = enemyPositions[i];
-			}
-		}
+		this->shooters = shooters;
+		this->seed = seed;
+		jobs = NULL;
+		world = NULL;
+		events = NULL;
+		clock = 0.0;
+		tick = 0;
+		lastDeltaTime = 0.0f;
+		lastHitChecks = 0;
+		lastPlayerPos = camera->GetPosition();
+		droppedBullets = 0;
+		lastShotChecks = 0;
+		firerate = config.initialFireInterval;
+		fireIntervalMin = config.fireIntervalMin;
+		fireIntervalSpread = config.fireIntervalSpread;
+		fireIntervalScale = 1.0f;
+		numBulletFrames = BULLET_FRAME_COUNT;
 	}
 	
-	// Add single bullet
-	void AddBullet(vec3 enemyPos, vec3 playerPos) {
+	// Add single bullet fired at game time `time` that flies at most range, returns an
+	// invalid handle when the pool is full
+	PoolHandle AddBullet(vec3 enemyPos, vec3 playerPos, double time, float range = BULLET_MAX_RANGE) {
 		vec3 direction = playerPos - enemyPos;
 		// Slightly raise bullet start position to avoid ground collision
-		vec3 bulletStartPos = enemyPos + vec3(0.0f, 2.0f, 0.0f);
-		bullets.push_back(Bullet(bulletStartPos, direction));
+		vec3 bulletStartPos = enemyPos + vec3(0.0f, BULLET_MUZZLE_HEIGHT, 0.0f);
+		PoolHandle handle = bullets.Add(Bullet(bulletStartPos, direction), time, range);
+		if (!handle.IsValid()) {
+			droppedBullets++;
+			return handle;
+		}
+		expiries.Schedule(TimerDue(bullets.ExpireTime(bullets.IndexOf(handle))), handle);
+		hitChecks.Schedule(HitCheckDue(time), handle);
+		return handle;
 	}
 	
-	// Check if bullet hits player
-	bool CheckBulletHitPlayer(float hitRadius = 5.0f) {  // Increased collision radius from 2.0f to 5.0f
+	// Check if bullet hits player. Tests the bullets whose hit check came due, each in
+	// closed form against the player's path over the last tick, so hits do not depend on
+	// the tick length. A bullet that misses is checked again when it could first have
+	// closed the distance. Call once per Update, after UpdateBullets.
+	bool CheckBulletHitPlayer(float hitRadius = BULLET_HIT_RADIUS) {  // Increased collision radius from 2.0f to 5.0f
 		vec3 playerPos = camera->GetPosition();
-		
-		for (size_t i = 0; i < bullets.size(); i++) {
-			float distance = length(bullets[i].position - playerPos);
-			if (distance <= hitRadius) {
-				cout << "Player hit! Distance: " << distance << ", Radius: " << hitRadius << endl;
-				bullets.erase(bullets.begin() + i);
-				return true;  // Player hit
+		vec3 fromPos = lastPlayerPos;
+		lastPlayerPos = playerPos;
+
+		candidates.clear();
+		hitChecks.Advance(TimerNow(clock), [&](PoolHandle handle, unsigned long long) {
+			if (bullets.Contains(handle))
+				candidates.push_back(handle); // Gone bullets' checks just lapse
+		});
+		lastHitChecks = candidates.size();
+		if (candidates.empty())
+			return false;
+
+		BulletSweep s;
+		s.from = bullets.LocalTime(clock - lastDeltaTime);
+		s.to = bullets.LocalTime(clock);
+		s.start = fromPos;
+		s.velocity = lastDeltaTime > 0.0f ? (playerPos - fromPos) / lastDeltaTime : vec3(0.0f);
+		s.radius = hitRadius;
+		s.maxSpeed = PLAYER_MAX_SPEED;
+		bullets.Gather(candidates, sweep);
+		BulletSweepLanes lanes = sweep.Lanes();
+		ParallelFor(jobs, candidates.size(), BULLET_CHUNK, [&](size_t begin, size_t end) {
+			SweepBulletLanes(lanes, begin, end, s);
+		});
+
+		// The first hit in check order counts, the others go on flying
+		size_t hit = candidates.size();
+		for (size_t k = 0; k < candidates.size(); k++) {
+			if (hit == candidates.size() && sweep.Hit(k)) {
+				hit = k;
+				continue;
 			}
+			size_t i = bullets.IndexOf(candidates[k]);
+			double next = bullets.GameTime(sweep.NextCheck(k));
+			if (next < bullets.ExpireTime(i))
+				hitChecks.Schedule(HitCheckDue(next), candidates[k]);
 		}
-		return false;
+		if (hit == candidates.size())
+			return false;
+
+		vec3 hitPos = bullets.Position(bullets.IndexOf(candidates[hit]), clock);
+		if (events)
+			events->Push(GameEvent(GAME_EVENT_PLAYER_HIT, hitPos, length(hitPos - playerPos)));
+		bullets.Remove(candidates[hit]);
+		return true;  // Player hit
 	}
 	
 	// Update bullets and shooting logic
-	void Update(float deltaTime,GLuint score) {
-		this->view = camera->GetViewMatrix();
-		this->projection = perspective(radians(camera->GetZoom()), windowSize.x / windowSize.y, 0.1f, 500.0f);
+	void Update(float deltaTime, unsigned int score) {
+		UpdateShooters(deltaTime, score);
+		UpdateBullets(deltaTime);
+	}
+
+	// Split the loops below over these workers (NULL: run them inline)
+	void SetJobSystem(JobSystem* jobs) {
+		this->jobs = jobs;
+	}
+
+	// Report player hits and bullets shot down here (NULL: nowhere)
+	void SetEventBus(EventBus* events) {
+		this->events = events;
+	}
+
+	// Stretch every fire interval scheduled from now on by scale
+	void SetFireIntervalScale(float scale) {
+		fireIntervalScale = scale;
+	}
+
+	// Stop bullets at these walls (NULL: they fly their full range)
+	void SetWorld(const StaticBVH* world) {
+		this->world = world;
+	}
+
+	// Fire these shooters in the next UpdateShooters, one shot per entry, on top of their
+	// timers (Enemy::GetShotRequests)
+	void QueueShots(const std::vector<EntityId>& ids) {
+		requestedShots.insert(requestedShots.end(), ids.begin(), ids.end());
+	}
+
+	// Start new shooters' timers and fire the due ones; first half of Update
+	void UpdateShooters(float deltaTime, unsigned int score) {
+		// Shooters added since the last tick fire one interval after they appeared, at the
+		// interval in force then
+		shooters->TakeAdded(newShooters);
+		for (size_t i = 0; i < newShooters.size(); i++) {
+			if (shooters->Contains(newShooters[i]))
+				shotTimers.Schedule(TimerDue(clock + firerate * fireIntervalScale), newShooters[i]);
+		}
+
 		firerate =firerate*score/(score+1.0f);
+		lastDeltaTime = deltaTime;
+		tick++;
+		clock += deltaTime;
 
 		// Update enemy shooting timers and fire bullets
-		UpdateEnemyShooting(deltaTime);
-		
-		// Update bullet positions
-		UpdateBullets(deltaTime);
-
+		UpdateEnemyShooting();
 	}
 	
-	// Update enemy shooting logic
-	void UpdateEnemyShooting(float deltaTime) {
+	// Fire every shooter whose timer ran out, and the queued shots; costs nothing for the
+	// ones still waiting. Shooters whose script does the firing let their timers lapse.
+	// A shooter without line of sight to the player holds its fire until the next
+	// interval. The due shots' paths are traced through the room in one batch on the
+	// workers, then fired in timer order.
+	void UpdateEnemyShooting() {
 		vec3 playerPos = camera->GetPosition();
-		
-		for (auto& shooter : enemyShooters) {
-			shooter.fireTimer += deltaTime;
-			
-			if (shooter.fireTimer >= shooter.fireRate) {
-				AddBullet(shooter.enemyPosition, playerPos);
-				shooter.fireTimer = 0.0f;
-				
-				// 重置射击间隔，增加一些随机性
-				shooter.fireRate = 1.5f + (rand() % 200) / 100.0f;
+		Span<const vec3> positions = shooters->Positions();
+		Span<const EnemyOrders> orders = shooters->Orders();
+		dueShooters.clear();
+		dueTicks.clear();
+		shotTimers.Advance(TimerNow(clock), [&](EntityId id, unsigned long long due) {
+			if (!shooters->Contains(id) || orders[shooters->IndexOf(id)].scriptedFire)
+				return; // Killed since, its timer just lapses
+			dueShooters.push_back(id);
+			dueTicks.push_back(due);
+		});
+		size_t timedShots = dueShooters.size();
+		for (size_t k = 0; k < requestedShots.size(); k++) {
+			if (!shooters->Contains(requestedShots[k]))
+				continue;
+			dueShooters.push_back(requestedShots[k]);
+			dueTicks.push_back(TimerNow(clock));
+		}
+		requestedShots.clear();
+
+		shotRanges.resize(dueShooters.size());
+		ParallelFor(jobs, dueShooters.size(), STATIC_RAY_CHUNK, [&](size_t begin, size_t end) {
+			for (size_t k = begin; k < end; k++) {
+				vec3 enemyPos = positions[shooters->IndexOf(dueShooters[k])];
+				vec3 muzzle = enemyPos + vec3(0.0f, BULLET_MUZZLE_HEIGHT, 0.0f);
+				vec3 toPlayer = playerPos - enemyPos;
+				float distance = length(toPlayer);
+				shotRanges[k] = BULLET_MAX_RANGE;
+				if (!world || distance <= 0.0f)
+					continue;
+				if (world->SegmentBlocked(muzzle, muzzle + toPlayer)) {
+					shotRanges[k] = -1.0f;
+					continue;
+				}
+				float wall = world->Raycast(muzzle, toPlayer / distance, BULLET_MAX_RANGE);
+				if (wall >= 0.0f)
+					shotRanges[k] = wall;
 			}
+		});
+
+		for (size_t k = 0; k < dueShooters.size(); k++) {
+			EntityId id = dueShooters[k];
+			if (shotRanges[k] >= 0.0f)
+				AddBullet(positions[shooters->IndexOf(id)], playerPos, dueTicks[k] / TIMER_TICKS_PER_SECOND, shotRanges[k]);
+			if (k >= timedShots)
+				continue;
+
+			// 重置射击间隔，增加一些随机性
+			// Drawn from (entity id, tick) so the result does not depend on update order
+			unsigned long long key = ((unsigned long long)id.generation << 32) | id.slot;
+			float interval = (fireIntervalMin + fireIntervalSpread * HashRandomBelow(seed, RNG_STREAM_SHOOTER_FIRE, key, tick, 200) / 200.0f) * fireIntervalScale;
+			shotTimers.Schedule(TimerDue(clock + interval), id);
 		}
 	}
+
+	// Shooters with a pending shot
+	size_t GetPendingShotCount() const {
+		return shotTimers.Size();
+	}
 	
-	// 修改 UpdateBullets 方法以处理动画帧更新
+	// Drop bullets whose life ran out by the start of this tick; the last hit check has
+	// swept them up to then. Bullets need no other per-tick work. Second half of Update.
 	void UpdateBullets(float deltaTime) {
-		for (size_t i = 0; i < bullets.size(); ++i) { // 使用 ++i
-			// 移动子弹
-			bullets[i].position += bullets[i].direction * bullets[i].speed * deltaTime; // 确保乘以 deltaTime
-			bullets[i].lifetime -= deltaTime;
-
-			// 更新动画帧
-			if (numBulletFrames > 0) { // 仅当有动画帧时才更新
-				bullets[i].frameTimer += deltaTime;
-				if (bullets[i].frameTimer >= bullets[i].frameDuration) {
-					bullets[i].frameTimer -= bullets[i].frameDuration; // 或者 bullets[i].frameTimer = 0.0f;
-					bullets[i].currentFrameIndex = (bullets[i].currentFrameIndex + 1) % numBulletFrames;
-				}
-			}
+		bullets.Rebase(clock);
+		expiries.Advance(TimerNow(clock - deltaTime), [&](PoolHandle handle, unsigned long long) {
+			bullets.Remove(handle); // No-op for bullets already gone
+		});
+	}
 
-			// 移除超时或超出范围的子弹
-			if (bullets[i].lifetime <= 0.0f ||
-				glm::length(bullets[i].position) > 500.0f) { // 调整子弹最大活动范围
-				bullets.erase(bullets.begin() + i);
-				i--; // 因为删除了元素，调整索引
-			}
-		}
+	// Bullets tested by the last CheckBulletHitPlayer
+	size_t GetHitCheckCount() const {
+		return lastHitChecks;
 	}
 	
-	// Check player shooting
-	void CheckPlayerShooting(vec3 pos, vec3 dir) {
-		for (size_t i = 0; i < bullets.size(); i++) {
-			// 计算射线与子弹的距离
-			vec3 des = (pos.z - bullets[i].position.z) / (-dir.z) * dir + pos;
-			float distance = pow(bullets[i].position.x - des.x, 2) + pow(bullets[i].position.y - des.y, 2);
-			
-			if (distance <= 50) {  // 击中判定范围
-				bullets.erase(bullets.begin() + i);
-				score++;
-				i--;
-			}
+	// Shoot down every bullet within BULLET_SHOT_RADIUS of the player's shots this tick, up
+	// to where each one stopped (Enemy::GetShots); shots go through bullets. The bullets
+	// are filed in a grid once for all the shots, so a shot tests the bullets in the cells
+	// along it, not all of them. Returns how many went down.
+	unsigned int CheckPlayerShooting(const std::vector<HitscanRay>& shots) {
+		lastShotChecks = 0;
+		if (shots.empty() || bullets.Size() == 0)
+			return 0;
+		shotGrid.Build(bullets, clock, jobs);
+		shotHits.clear();
+		for (size_t s = 0; s < shots.size(); s++) {
+			lastShotChecks += shotGrid.ForEachNearRay(shots[s].origin, shots[s].dir, shots[s].maxDistance, BULLET_SHOT_RADIUS, [&](size_t i, float) {
+				// Bullets whose life ran out this tick are only waiting for UpdateBullets
+				if (bullets.ExpireTime(i) > clock)
+					shotHits.push_back(bullets.HandleAt(i));
+			});
+		}
+		unsigned int destroyed = 0;
+		for (size_t i = 0; i < shotHits.size(); i++) {
+			// Two shots may pass the same bullet, the second finds it gone
+			if (!bullets.Contains(shotHits[i]))
+				continue;
+			if (events)
+				events->Push(GameEvent(GAME_EVENT_BULLET_SHOT_DOWN, bullets.Position(bullets.IndexOf(shotHits[i]), clock)));
+			bullets.Remove(shotHits[i]);
+			destroyed++;
 		}
+		return destroyed;
+	}
+
+	// Bullets tested by the last CheckPlayerShooting
+	size_t GetShotCheckCount() const {
+		return lastShotChecks;
 	}
 
 	// Check if game is over (now based on whether there are too many bullets or player is hit)
@@ -204,100 +339,30 @@ public:
 		return false;
 	}
 
-	GLuint GetScore() {
-		return score;
-	}
-	
 	// Get current bullet count (for debugging or UI display)
 	size_t GetBulletCount() const {
-		return bullets.size();
+		return bullets.Size();
 	}
-	
-	// 修改 Render 方法以渲染正确的动画帧
-	void Render(Shader* shaderToUse, GLuint depthMapID = 0) {
-		if (bulletFrames.empty() || !camera) return; // 如果没有加载模型帧或相机无效则返回
-
-		// projection 和 view 应该在循环外更新一次，因为它们对于所有子弹都是相同的
-		// （已在 BallManager::Update 中更新了 this->projection 和 this->view）
-
-		for (size_t i = 0; i < bullets.size(); ++i) {
-			if (bullets[i].currentFrameIndex >= numBulletFrames) continue; // 安全检查
-
-			Model* currentFrameModel = bulletFrames[bullets[i].currentFrameIndex];
-			if (!currentFrameModel) continue; // 安全检查
-
-			const auto& subMeshes = currentFrameModel->GetSubMeshes();
-			if (subMeshes.empty()) continue;
-			const auto& firstSubMesh = subMeshes[0];
-
-			model_matrix_temp = glm::mat4(1.0f);
-			model_matrix_temp = glm::translate(model_matrix_temp, bullets[i].position);
-			// 如果子弹需要朝向飞行方向，这里还需要计算旋转
-			// glm::mat4 rotationMatrix = glm::lookAt(glm::vec3(0.0f), bullets[i].direction, camera->GetUp()); // GetUp()可能不合适，用worldUp
-			// model_matrix_temp *= glm::inverse(rotationMatrix); // lookAt 返回的是视图矩阵，需要逆
-			// 更简单的方式是用四元数或直接构建旋转矩阵，但如果dot模型本身是对称的，可能不需要旋转。
-			model_matrix_temp = glm::scale(model_matrix_temp, glm::vec3(0.5f)); // 子弹大小
-
-			Shader* currentShader = shaderToUse;
-			if (currentShader == NULL) {
-				currentShader = ballShader;
-				currentShader->Bind();
-				currentShader->SetMat4("projection", projection); // 使用成员变量
-				currentShader->SetMat4("view", view);             // 使用成员变量
-				currentShader->SetVec3("viewPos", camera->GetPosition());
-				currentShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
-			} else {
-				currentShader->Bind();
-			}
 
-			currentShader->SetMat4("model", model_matrix_temp);
-
-			if (currentShader == ballShader && depthMapID != 0) {
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, depthMapID);
-				// ballShader->SetInt("shadowMap", 0); // 已在LoadModelsAndShader中设置
-			}
-
-			glBindVertexArray(firstSubMesh.VAO);
-			glDrawElements(GL_TRIANGLES, firstSubMesh.indexCount, GL_UNSIGNED_INT, 0);
-		}
+	size_t GetBulletCapacity() const {
+		return bullets.Capacity();
+	}
 
-		if (shaderToUse == NULL && ballShader) {
-			ballShader->Unbind();
-		}
-		glBindVertexArray(0);
+	size_t GetDroppedBulletCount() const {
+		return droppedBullets;
 	}
 
-private:
-	// 修改 LoadModel 为 LoadModelsAndShader
-	void LoadModelsAndShader() {
-		// 加载所有子弹动画帧模型
-		std::string frameNames[] = {"dot1.obj", "dot2.obj", "dot3.obj", "dot4.obj", "dot5.obj"};
-		numBulletFrames = sizeof(frameNames) / sizeof(frameNames[0]);
-
-		for (int i = 0; i < numBulletFrames; ++i) {
-			Model* frameModel = new Model("res/model/" + frameNames[i]);
-			if (frameModel) { // TODO: 检查模型是否成功加载 (例如，通过GetSubMeshes().empty())
-				bulletFrames.push_back(frameModel);
-			} else {
-				std::cout << "错误: 无法加载子弹模型帧 " << frameNames[i] << std::endl;
-				// 处理加载失败的情况，例如将numBulletFrames设置为0或抛出异常
-			}
-		}
-		if(bulletFrames.empty()){ // 如果一个都没加载成功
-			numBulletFrames = 0;
-			std::cout << "警告: 没有成功加载任何子弹模型帧!" << std::endl;
-		}
+	bool IsBulletAlive(PoolHandle handle) const {
+		return bullets.Contains(handle);
+	}
 
+	const BulletStore& GetBullets() const {
+		return bullets;
+	}
 
-		ballShader = new Shader("res/shader/ball.vert", "res/shader/ball.frag"); // 假设子弹使用 ball 着色器
-		ballShader->Bind();
-		ballShader->SetVec3("color", glm::vec3(1.0f, 0.2f, 0.2f));  // 例如，红色子弹
-		ballShader->SetInt("shadowMap", 0); // 告诉 ballShader 从纹理单元0读取阴影贴图
-		ballShader->SetVec3("lightPos", lightPos);
-		// ballShader->SetVec3("viewPos", camera->GetPosition()); // viewPos 在渲染时动态更新
-		ballShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
-		ballShader->Unbind();
+	// Seconds simulated; bullets are evaluated at a game time
+	double GetClock() const {
+		return clock;
 	}
 };
 
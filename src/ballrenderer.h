@@ -0,0 +1,155 @@
+#ifndef BALLRENDERER_H
+#define BALLRENDERER_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <vector>
+using namespace std;
+#include "model.h"
+#include "shader.h"
+#include "camera.h"
+#include "ballmanager.h"
+
+// Draws the bullets owned by a BallManager. Holds all GL resources for bullets.
+class BallRenderer {
+private:
+	glm::vec2 windowSize;
+
+	std::vector<Model*> bulletFrames; // 存储子弹的所有动画帧模型
+	int numBulletFrames;              // 子弹动画的总帧数
+
+	Shader* ballShader; // 子弹共用一个着色器
+	glm::vec3 lightPos;
+	glm::mat4 lightSpaceMatrix;
+
+	const BallManager* balls;
+	const Camera* camera;
+	glm::mat4 model_matrix_temp; // 避免与 Model 类名冲突，并明确是临时变量
+	glm::mat4 projection;
+	glm::mat4 view;
+	float stepBehind; // Time to go until the current tick, for drawing between ticks
+public:
+	BallRenderer(glm::vec2 windowSize, const Camera* camera, const BallManager* balls) : stepBehind(0.0f) {
+		this->windowSize = windowSize;
+		this->camera = camera;
+		this->balls = balls;
+		this->lightPos = glm::vec3(0.0, 400.0, 150.0);
+		glm::mat4 lightProjection = glm::ortho(-100.0f, 100.0f, -100.0f, 100.0f, 1.0f, 500.0f);
+		glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0, 1.0, 0.0));
+		this->lightSpaceMatrix = lightProjection * lightView;
+
+		numBulletFrames = 0; // 初始化帧数
+		LoadModelsAndShader(); // 修改函数名，加载多个模型和着色器
+	}
+
+	~BallRenderer() { // 添加析构函数来释放模型资源
+		for (Model* frame : bulletFrames) {
+			delete frame;
+		}
+		bulletFrames.clear();
+		delete ballShader;
+	}
+
+	void Update() {
+		this->view = camera->GetViewMatrix();
+		this->projection = perspective(radians(camera->GetZoom()), windowSize.x / windowSize.y, 0.1f, 500.0f);
+	}
+
+	// Draw at this fraction of the way from the previous tick to the current one.
+	// Bullets are evaluated in closed form, so any time in between is exact.
+	void SetInterpolation(float alpha, float tickLength) {
+		stepBehind = tickLength * (1.0f - alpha);
+	}
+
+	// 修改 Render 方法以渲染正确的动画帧
+	void Render(Shader* shaderToUse, GLuint depthMapID = 0) {
+		if (bulletFrames.empty() || !camera) return; // 如果没有加载模型帧或相机无效则返回
+
+		// projection 和 view 应该在循环外更新一次，因为它们对于所有子弹都是相同的
+		// （已在 BallRenderer::Update 中更新了 this->projection 和 this->view）
+
+		const BulletStore& bullets = balls->GetBullets();
+		double time = balls->GetClock() - stepBehind;
+		for (size_t i = 0; i < bullets.Size(); ++i) {
+			int frameIndex = bullets.FrameIndex(i, time, numBulletFrames);
+			if (frameIndex >= numBulletFrames) continue; // 安全检查
+
+			Model* currentFrameModel = bulletFrames[frameIndex];
+			if (!currentFrameModel) continue; // 安全检查
+
+			const auto& subMeshes = currentFrameModel->GetSubMeshes();
+			if (subMeshes.empty()) continue;
+			const auto& firstSubMesh = subMeshes[0];
+
+			model_matrix_temp = glm::mat4(1.0f);
+			model_matrix_temp = glm::translate(model_matrix_temp, bullets.Position(i, time));
+			// 如果子弹需要朝向飞行方向，这里还需要计算旋转
+			// glm::mat4 rotationMatrix = glm::lookAt(glm::vec3(0.0f), bullets[i].direction, camera->GetUp()); // GetUp()可能不合适，用worldUp
+			// model_matrix_temp *= glm::inverse(rotationMatrix); // lookAt 返回的是视图矩阵，需要逆
+			// 更简单的方式是用四元数或直接构建旋转矩阵，但如果dot模型本身是对称的，可能不需要旋转。
+			model_matrix_temp = glm::scale(model_matrix_temp, glm::vec3(0.5f)); // 子弹大小
+
+			Shader* currentShader = shaderToUse;
+			if (currentShader == NULL) {
+				currentShader = ballShader;
+				currentShader->Bind();
+				currentShader->SetMat4("projection", projection); // 使用成员变量
+				currentShader->SetMat4("view", view);             // 使用成员变量
+				currentShader->SetVec3("viewPos", camera->GetPosition());
+				currentShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+			} else {
+				currentShader->Bind();
+			}
+
+			currentShader->SetMat4("model", model_matrix_temp);
+
+			if (currentShader == ballShader && depthMapID != 0) {
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, depthMapID);
+				// ballShader->SetInt("shadowMap", 0); // 已在LoadModelsAndShader中设置
+			}
+
+			glBindVertexArray(firstSubMesh.VAO);
+			glDrawElements(GL_TRIANGLES, firstSubMesh.indexCount, GL_UNSIGNED_INT, 0);
+		}
+
+		if (shaderToUse == NULL && ballShader) {
+			ballShader->Unbind();
+		}
+		glBindVertexArray(0);
+	}
+
+private:
+	// 修改 LoadModel 为 LoadModelsAndShader
+	void LoadModelsAndShader() {
+		// 加载所有子弹动画帧模型
+		std::string frameNames[] = {"dot1.obj", "dot2.obj", "dot3.obj", "dot4.obj", "dot5.obj"};
+		numBulletFrames = sizeof(frameNames) / sizeof(frameNames[0]);
+
+		for (int i = 0; i < numBulletFrames; ++i) {
+			Model* frameModel = new Model("res/model/" + frameNames[i]);
+			if (frameModel) { // TODO: 检查模型是否成功加载 (例如，通过GetSubMeshes().empty())
+				bulletFrames.push_back(frameModel);
+			} else {
+				std::cout << "错误: 无法加载子弹模型帧 " << frameNames[i] << std::endl;
+				// 处理加载失败的情况，例如将numBulletFrames设置为0或抛出异常
+			}
+		}
+		if(bulletFrames.empty()){ // 如果一个都没加载成功
+			numBulletFrames = 0;
+			std::cout << "警告: 没有成功加载任何子弹模型帧!" << std::endl;
+		}
+
+
+		ballShader = new Shader("res/shader/ball.vert", "res/shader/ball.frag"); // 假设子弹使用 ball 着色器
+		ballShader->Bind();
+		ballShader->SetVec3("color", glm::vec3(1.0f, 0.2f, 0.2f));  // 例如，红色子弹
+		ballShader->SetInt("shadowMap", 0); // 告诉 ballShader 从纹理单元0读取阴影贴图
+		ballShader->SetVec3("lightPos", lightPos);
+		// ballShader->SetVec3("viewPos", camera->GetPosition()); // viewPos 在渲染时动态更新
+		ballShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+		ballShader->Unbind();
+	}
+};
+
+#endif // !BALLRENDERER_H
@@ -0,0 +1,345 @@
+#ifndef BEHAVIOR_H
+#define BEHAVIOR_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <vector>
+using namespace std;
+#include "entitystore.h"
+#include "jobsystem.h"
+#include "timerwheel.h"
+
+const size_t BEHAVIOR_FRAME_BYTES = 512;        // Pooled coroutine frame size; bigger frames go to the heap
+const size_t BEHAVIOR_FRAME_HEADER = 16;        // Owning pool, in front of every frame; keeps frames 16-byte aligned
+const size_t BEHAVIOR_FRAMES_PER_BLOCK = 256;   // The frame pool grows this many frames at a time
+const size_t BEHAVIOR_CHUNK = 256;              // Behaviors resumed per parallel chunk
+
+// Things behaviors can wait for besides time. Signalled during a tick, the waiters resume
+// in the next BehaviorScheduler::Update.
+enum BehaviorEvent {
+    BEHAVIOR_EVENT_PLAYER_FIRED,    // The player pulled the trigger
+    BEHAVIOR_EVENT_ENEMY_KILLED,    // The player shot an enemy
+    BEHAVIOR_EVENT_COUNT
+};
+
+// Fixed-size blocks for coroutine frames. Grows a block of frames at a time and keeps freed
+// frames on a free list, so starting a behavior only allocates when more are alive than
+// ever before. Frames are created and destroyed between batches, never during one, so no
+// locking.
+class BehaviorFramePool {
+private:
+    vector<unsigned char*> blocks;
+    vector<unsigned char*> freeFrames;
+    size_t liveFrames;
+    size_t oversizeFrames;          // Frames too big for a block, allocated on the heap
+
+public:
+    BehaviorFramePool() : liveFrames(0), oversizeFrames(0) {}
+
+    ~BehaviorFramePool() {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            delete[] blocks[i];
+        }
+    }
+
+    BehaviorFramePool(const BehaviorFramePool&) = delete;
+    BehaviorFramePool& operator=(const BehaviorFramePool&) = delete;
+
+    void* Allocate(size_t size) {
+        unsigned char* frame;
+        if (size > BEHAVIOR_FRAME_BYTES) {
+            frame = (unsigned char*)::operator new(size + BEHAVIOR_FRAME_HEADER);
+            oversizeFrames++;
+        }
+        else {
+            if (freeFrames.empty())
+                Grow();
+            frame = freeFrames.back();
+            freeFrames.pop_back();
+        }
+        liveFrames++;
+        *(BehaviorFramePool**)frame = this;
+        return frame + BEHAVIOR_FRAME_HEADER;
+    }
+
+    // Return a frame to the pool it came from
+    static void Release(void* p, size_t size) {
+        unsigned char* frame = (unsigned char*)p - BEHAVIOR_FRAME_HEADER;
+        BehaviorFramePool* pool = *(BehaviorFramePool**)frame;
+        pool->liveFrames--;
+        if (size > BEHAVIOR_FRAME_BYTES)
+            ::operator delete(frame);
+        else
+            pool->freeFrames.push_back(frame);
+    }
+
+    size_t GetLiveCount() const { return liveFrames; }
+    size_t GetCapacity() const { return blocks.size() * BEHAVIOR_FRAMES_PER_BLOCK; }
+    size_t GetOversizeCount() const { return oversizeFrames; }
+
+private:
+    void Grow() {
+        const size_t stride = BEHAVIOR_FRAME_HEADER + BEHAVIOR_FRAME_BYTES;
+        unsigned char* block = new unsigned char[stride * BEHAVIOR_FRAMES_PER_BLOCK];
+        blocks.push_back(block);
+        freeFrames.reserve(GetCapacity());
+        for (size_t i = BEHAVIOR_FRAMES_PER_BLOCK; i > 0; i--) {
+            freeFrames.push_back(block + (i - 1) * stride);
+        }
+    }
+};
+
+enum BehaviorWait {
+    BEHAVIOR_WAIT_TIME,     // Resume after waitSeconds
+    BEHAVIOR_WAIT_EVENT     // Resume on waitEvent, or after waitSeconds if timed
+};
+
+class Behavior;
+
+// State a suspended behavior leaves for the scheduler: what it waits for
+struct BehaviorPromise {
+    unsigned char wait;     // BehaviorWait
+    bool timed;             // An event wait that also ends after waitSeconds
+    bool signalled;         // The event, not the time, ended the last event wait
+    int waitEvent;          // BehaviorEvent
+    double waitSeconds;     // From the moment it suspended
+
+    BehaviorPromise() : wait(BEHAVIOR_WAIT_TIME), timed(false), signalled(false), waitEvent(0), waitSeconds(0.0) {}
+
+    // Frames come from the pool of the behavior's first argument, a context with
+    // GetFramePool(); there is no other way to make one
+    template <typename Context, typename... Args>
+    static void* operator new(size_t size, Context& context, Args&...) {
+        return context.GetFramePool().Allocate(size);
+    }
+    static void operator delete(void* p, size_t size) {
+        BehaviorFramePool::Release(p, size);
+    }
+
+    Behavior get_return_object();
+    suspend_always initial_suspend() noexcept { return suspend_always(); }   // Runs from the next Update
+    suspend_always final_suspend() noexcept { return suspend_always(); }     // The scheduler frees the frame
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+};
+
+// A behavior script: a coroutine returning Behavior that co_awaits WaitSeconds and
+// WaitEvent. Owns its frame until handed to BehaviorScheduler::Start.
+class Behavior {
+private:
+    coroutine_handle<BehaviorPromise> handle;
+
+public:
+    typedef BehaviorPromise promise_type;
+
+    explicit Behavior(coroutine_handle<BehaviorPromise> handle) : handle(handle) {}
+    Behavior(Behavior&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    Behavior(const Behavior&) = delete;
+    Behavior& operator=(const Behavior&) = delete;
+    ~Behavior() {
+        if (handle)
+            handle.destroy();
+    }
+
+    coroutine_handle<BehaviorPromise> Release() {
+        coroutine_handle<BehaviorPromise> h = handle;
+        handle = nullptr;
+        return h;
+    }
+};
+
+inline Behavior BehaviorPromise::get_return_object() {
+    return Behavior(coroutine_handle<BehaviorPromise>::from_promise(*this));
+}
+
+// co_await WaitSeconds(s): resume s seconds of game time later (0: next Update)
+struct BehaviorTimeAwaiter {
+    double seconds;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(coroutine_handle<BehaviorPromise> h) const noexcept {
+        h.promise().wait = BEHAVIOR_WAIT_TIME;
+        h.promise().waitSeconds = seconds;
+    }
+    void await_resume() const noexcept {}
+};
+
+inline BehaviorTimeAwaiter WaitSeconds(double seconds) {
+    BehaviorTimeAwaiter awaiter = { seconds };
+    return awaiter;
+}
+
+// co_await WaitEvent(e[, timeout]): resume when e is signalled, or after timeout seconds
+// if one is given (>= 0). True if the event came.
+struct BehaviorEventAwaiter {
+    int event;
+    double timeout;
+    coroutine_handle<BehaviorPromise> handle;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(coroutine_handle<BehaviorPromise> h) noexcept {
+        handle = h;
+        h.promise().wait = BEHAVIOR_WAIT_EVENT;
+        h.promise().waitEvent = event;
+        h.promise().timed = timeout >= 0.0;
+        h.promise().waitSeconds = timeout;
+    }
+    bool await_resume() const noexcept { return handle.promise().signalled; }
+};
+
+inline BehaviorEventAwaiter WaitEvent(BehaviorEvent event, double timeout = -1.0) {
+    BehaviorEventAwaiter awaiter = { (int)event, timeout, nullptr };
+    return awaiter;
+}
+
+// Runs one behavior per entity. Behaviors sleep in a TimerWheel or on an event's waiting
+// list and cost nothing until they wake; each Update resumes the woken ones as a batch
+// over the workers, then files every one that suspended again under what it now waits
+// for. A behavior may only write its own entity's state while it runs, so the batch
+// gives the same result on any number of threads. Frames come from a BehaviorFramePool.
+class BehaviorScheduler {
+private:
+    struct Agent {
+        coroutine_handle<BehaviorPromise> handle;
+        EntityId id;
+        unsigned int sequence;      // Bumped at every wake, so a wait's other entry goes stale
+    };
+    struct Wake {
+        EntityId id;
+        unsigned int sequence;
+    };
+
+    BehaviorFramePool pool;         // Declared first: outlives the frames agents hold
+    vector<Agent> agents;           // By entity slot
+    TimerWheel<Wake> timers;
+    vector<Wake> waiting[BEHAVIOR_EVENT_COUNT];
+    unsigned int signalled;         // Event bits since the last Update
+    vector<EntityId> starting;      // Started since the last Update
+    vector<EntityId> ready;         // Woken in the current Update
+    double clock;                   // Seconds simulated, the timers' time
+    size_t running;
+    size_t lastResumed;
+
+public:
+    BehaviorScheduler(size_t capacity) : agents(capacity), signalled(0), clock(0.0), running(0), lastResumed(0) {
+        for (size_t i = 0; i < capacity; i++) {
+            agents[i].handle = nullptr;
+            agents[i].sequence = 0;
+        }
+    }
+
+    ~BehaviorScheduler() {
+        for (size_t i = 0; i < agents.size(); i++) {
+            if (agents[i].handle)
+                agents[i].handle.destroy();
+        }
+    }
+
+    BehaviorFramePool& GetFramePool() { return pool; }
+
+    // Give the entity this behavior, replacing any it had; it first runs in the next Update
+    void Start(EntityId id, Behavior behavior) {
+        Stop(id);
+        Agent& agent = agents[id.slot];
+        agent.handle = behavior.Release();
+        agent.id = id;
+        agent.sequence++;
+        starting.push_back(id);
+        running++;
+    }
+
+    // End the entity's behavior where it is suspended; call when the entity goes away.
+    // Its pending waits lapse.
+    void Stop(EntityId id) {
+        Agent& agent = agents[id.slot];
+        if (!IsCurrent(id))
+            return;
+        agent.handle.destroy();
+        agent.handle = nullptr;
+        agent.sequence++;
+        running--;
+    }
+
+    void Signal(BehaviorEvent event) {
+        signalled |= 1u << event;
+    }
+
+    // Advance deltaTime seconds and resume what woke, started or was signalled.
+    // afterResume(id) runs serially for each resumed behavior, in a fixed order, so the
+    // game can pick up what it asked for.
+    template <typename F>
+    void Update(JobSystem* jobs, float deltaTime, F afterResume) {
+        clock += deltaTime;
+        ready.clear();
+        for (size_t i = 0; i < starting.size(); i++) {
+            if (IsCurrent(starting[i]))
+                ready.push_back(starting[i]);
+        }
+        starting.clear();
+        for (int e = 0; e < BEHAVIOR_EVENT_COUNT; e++) {
+            if (!(signalled & (1u << e))) {
+                continue;
+            }
+            for (size_t i = 0; i < waiting[e].size(); i++) {
+                if (WakeUp(waiting[e][i]))
+                    agents[waiting[e][i].id.slot].handle.promise().signalled = true;
+            }
+            waiting[e].clear();
+        }
+        signalled = 0;
+        timers.Advance(TimerNow(clock), [&](const Wake& wake, unsigned long long) {
+            if (WakeUp(wake))
+                agents[wake.id.slot].handle.promise().signalled = false;
+        });
+        lastResumed = ready.size();
+        if (ready.empty())
+            return;
+
+        ParallelFor(jobs, ready.size(), BEHAVIOR_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t k = begin; k < end; k++) {
+                agents[ready[k].slot].handle.resume();
+            }
+        });
+
+        for (size_t k = 0; k < ready.size(); k++) {
+            EntityId id = ready[k];
+            Agent& agent = agents[id.slot];
+            afterResume(id);
+            if (agent.handle.done()) {
+                Stop(id);
+                continue;
+            }
+            const BehaviorPromise& promise = agent.handle.promise();
+            Wake wake = { id, agent.sequence };
+            if (promise.wait == BEHAVIOR_WAIT_EVENT)
+                waiting[promise.waitEvent].push_back(wake);
+            if (promise.wait == BEHAVIOR_WAIT_TIME || promise.timed)
+                timers.Schedule(TimerDue(clock + promise.waitSeconds), wake);
+        }
+    }
+
+    size_t GetRunningCount() const { return running; }
+    // Behaviors the last Update resumed
+    size_t GetLastResumedCount() const { return lastResumed; }
+    const BehaviorFramePool& GetFramePool() const { return pool; }
+
+private:
+    bool IsCurrent(EntityId id) const {
+        const Agent& agent = agents[id.slot];
+        return agent.handle && agent.id.slot == id.slot && agent.id.generation == id.generation;
+    }
+
+    // Queue a behavior whose wait ended, unless it was stopped or already woken since
+    bool WakeUp(const Wake& wake) {
+        Agent& agent = agents[wake.id.slot];
+        if (!IsCurrent(wake.id) || agent.sequence != wake.sequence)
+            return false;
+        agent.sequence++;
+        ready.push_back(wake.id);
+        return true;
+    }
+};
+
+#endif // !BEHAVIOR_H
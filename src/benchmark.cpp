@@ -0,0 +1,8 @@
+// Window-less benchmark runner, same as "Shoot Game.exe --bench" without --render:
+//   g++ -O2 -std=c++20 -Ilibrary/include src/benchmark.cpp -o shootgame-bench
+//   ./shootgame-bench --scenario bench/enemies.ini --out bench-results.json
+#include "benchmark.h"
+
+int main(int argc, char** argv) {
+    return RunBenchmark(argc, argv);
+}
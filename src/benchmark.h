@@ -0,0 +1,392 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+#include "headless.h"
+#include "inputstate.h"
+#include "simconfig.h"
+#include "simulation.h"
+
+// One benchmark run: game scale, run length and window size when rendering
+struct BenchmarkScenario {
+    string name;
+    unsigned long long ticks;       // Measured ticks
+    unsigned long long warmupTicks; // Run first, not measured
+    float tickRate;
+    unsigned long long seed;
+    SimConfig config;
+    int windowWidth;
+    int windowHeight;
+
+    BenchmarkScenario() : ticks(600), warmupTicks(60), tickRate(60.0f), seed(1), windowWidth(1960), windowHeight(1080) {}
+};
+
+// Apply one "key = value" line. Returns false for unknown keys or bad numbers.
+bool SetScenarioValue(BenchmarkScenario& scenario, const string& key, const string& value) {
+    char* end = NULL;
+    double number = strtod(value.c_str(), &end);
+    if (end == value.c_str() || *end != '\0' || number < 0.0)
+        return false;
+    SimConfig& c = scenario.config;
+    if (key == "ticks") scenario.ticks = (unsigned long long)number;
+    else if (key == "warmup_ticks") scenario.warmupTicks = (unsigned long long)number;
+    else if (key == "hz" && number > 0.0) scenario.tickRate = (float)number;
+    else if (key == "seed") scenario.seed = (unsigned long long)number;
+    else if (key == "window_width") scenario.windowWidth = (int)number;
+    else if (key == "window_height") scenario.windowHeight = (int)number;
+    else if (key == "enemies") c.initialEnemies = c.maxEnemies = (unsigned int)number;
+    else if (key == "initial_enemies") c.initialEnemies = (unsigned int)number;
+    else if (key == "max_enemies") c.maxEnemies = (unsigned int)number;
+    else if (key == "max_entities") c.maxEntities = (size_t)number;
+    else if (key == "enemy_spawn_batch") c.enemySpawnBatch = (unsigned int)number;
+    else if (key == "enemy_spawn_interval") c.enemySpawnInterval = (float)number;
+    else if (key == "enemy_spawn_range") c.enemySpawnRange = (float)number;
+    else if (key == "enemy_safe_zone") c.enemySafeZone = (float)number;
+    else if (key == "enemy_spacing") c.enemySpacing = (float)number;
+    else if (key == "enemy_speed") c.enemyMoveSpeed = (float)number;
+    else if (key == "enemy_stop_distance") c.enemyStopDistance = (float)number;
+    else if (key == "enemy_separation" && number > 0.0) c.enemySeparation = (float)number;
+    else if (key == "behaviors") c.enemyBehaviors = number != 0.0;
+    else if (key == "nav_cell_size" && number > 0.0) c.navCellSize = (float)number;
+    else if (key == "nav_cells_per_tick") c.navCellsPerTick = (unsigned int)number;
+    else if (key == "health_packs") c.initialHealthPacks = c.maxHealthPacks = (unsigned int)number;
+    else if (key == "initial_health_packs") c.initialHealthPacks = (unsigned int)number;
+    else if (key == "max_health_packs") c.maxHealthPacks = (unsigned int)number;
+    else if (key == "health_pack_spawn_interval") c.healthPackSpawnInterval = (float)number;
+    else if (key == "max_bullets") c.maxBullets = (size_t)number;
+    else if (key == "threads") c.workerThreads = (unsigned int)number;
+    else if (key == "frame_budget_ms") c.frameBudgetMs = (float)number;
+    else if (key == "initial_fire_interval") c.initialFireInterval = (float)number;
+    else if (key == "fire_interval_min") c.fireIntervalMin = (float)number;
+    else if (key == "fire_interval_spread") c.fireIntervalSpread = (float)number;
+    else if (key == "lod") c.lodEnabled = number != 0.0;
+    else if (key == "lod_near") c.lodNearDistance = (float)number;
+    else if (key == "lod_mid") c.lodMidDistance = (float)number;
+    else if (key == "lod_far") c.lodFarDistance = (float)number;
+    else return false;
+    return true;
+}
+
+static string TrimSpaces(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == string::npos)
+        return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+// Read an INI-style scenario file. Every "[name]" section is one scenario; "key = value"
+// lines before the first section are defaults shared by all of them. '#' starts a comment.
+bool LoadBenchmarkScenarios(const string& path, vector<BenchmarkScenario>& outScenarios) {
+    ifstream file(path.c_str());
+    if (!file.is_open()) {
+        cout << "Could not open scenario file: " << path << endl;
+        return false;
+    }
+    BenchmarkScenario defaults;
+    BenchmarkScenario* current = &defaults;
+    size_t firstNew = outScenarios.size();
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != string::npos)
+            line = line.substr(0, comment);
+        line = TrimSpaces(line);
+        if (line.empty())
+            continue;
+        if (line[0] == '[' && line[line.size() - 1] == ']') {
+            outScenarios.push_back(defaults);
+            outScenarios.back().name = TrimSpaces(line.substr(1, line.size() - 2));
+            current = &outScenarios.back();
+            continue;
+        }
+        size_t equals = line.find('=');
+        if (equals == string::npos
+            || !SetScenarioValue(*current, TrimSpaces(line.substr(0, equals)), TrimSpaces(line.substr(equals + 1)))) {
+            cout << path << ":" << lineNumber << ": bad setting \"" << line << "\"" << endl;
+            return false;
+        }
+    }
+    if (outScenarios.size() == firstNew) {
+        cout << path << ": no [scenario] sections" << endl;
+        return false;
+    }
+    return true;
+}
+
+struct TimingStats {
+    double mean;
+    double p50;
+    double p99;
+    double max;
+
+    TimingStats() : mean(0.0), p50(0.0), p99(0.0), max(0.0) {}
+};
+
+// Nearest-rank percentiles; sorts samples
+TimingStats ComputeTimingStats(vector<double>& samples) {
+    TimingStats stats;
+    if (samples.empty())
+        return stats;
+    sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        sum += samples[i];
+    }
+    size_t n = samples.size();
+    stats.mean = sum / n;
+    stats.p50 = samples[(size_t)ceil(0.50 * n) - 1];
+    stats.p99 = samples[(size_t)ceil(0.99 * n) - 1];
+    stats.max = samples[n - 1];
+    return stats;
+}
+
+// Lets the windowed build time rendering too. Begin shows a new game built from the
+// scenario and hands back its simulation; Update advances it one tick (simulation plus
+// render-side state); Render draws and presents one frame.
+class BenchmarkRenderer {
+public:
+    virtual ~BenchmarkRenderer() {}
+    virtual Simulation* Begin(const BenchmarkScenario& scenario) = 0;
+    virtual void Update(const InputState& input, float deltaTime) = 0;
+    virtual void Render() = 0;
+    virtual void End() = 0;
+};
+
+static string JsonString(const string& s) {
+    string out = "\"";
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\')
+            out += '\\';
+        out += s[i];
+    }
+    return out + "\"";
+}
+
+static void WriteTimingJson(ostream& json, const char* name, vector<double>& seconds, bool last) {
+    TimingStats stats = ComputeTimingStats(seconds);
+    json << "        " << JsonString(name) << ": { \"mean_us\": " << stats.mean * 1e6
+        << ", \"p50_us\": " << stats.p50 * 1e6 << ", \"p99_us\": " << stats.p99 * 1e6
+        << ", \"max_us\": " << stats.max * 1e6 << " }" << (last ? "\n" : ",\n");
+}
+
+// Mean entities per LOD bucket and mean updates per tick, from per-tick sums
+static void WriteLodJson(ostream& json, const char* name, const LodStats& sums, unsigned long long ticks, bool last) {
+    double n = ticks > 0 ? (double)ticks : 1.0;
+    json << "        " << JsonString(name) << ": { \"buckets\": [";
+    for (int b = 0; b < LOD_BUCKET_COUNT; b++) {
+        json << (b > 0 ? ", " : "") << sums.entities[b] / n;
+    }
+    json << "], \"updated\": " << sums.updated / n << " }" << (last ? "\n" : ",\n");
+}
+
+// Run one scenario and append its JSON object (without separator) to json
+void RunBenchmarkScenario(const BenchmarkScenario& scenario, BenchmarkRenderer* renderer, ostream& json) {
+    typedef chrono::steady_clock Clock;
+    Simulation* ownSim = NULL;
+    Simulation* sim;
+    if (renderer)
+        sim = renderer->Begin(scenario);
+    else
+        sim = ownSim = new Simulation(scenario.seed, scenario.config);
+    sim->SetProfiling(true);
+
+    const float deltaTime = 1.0f / scenario.tickRate;
+    vector<double> systemSamples[SIM_SYSTEM_COUNT];
+    vector<double> stepSamples, renderSamples;
+    for (int s = 0; s < SIM_SYSTEM_COUNT; s++) {
+        systemSamples[s].reserve((size_t)scenario.ticks);
+    }
+    stepSamples.reserve((size_t)scenario.ticks);
+    LodStats enemyLod;              // Summed over the measured ticks
+    double entityTicks = 0.0;
+    double hitCheckTicks = 0.0;
+    double shotCheckTicks = 0.0;
+    double wallSeconds = 0.0;
+    unsigned long long measured = 0;
+
+    unsigned long long total = scenario.warmupTicks + scenario.ticks;
+    for (unsigned long long tick = 0; tick < total && !sim->IsOver(); tick++) {
+        InputState input = ScriptedInput(tick, scenario.tickRate);
+        Clock::time_point start = Clock::now();
+        if (renderer)
+            renderer->Update(input, deltaTime);
+        else
+            sim->Step(input, deltaTime);
+        Clock::time_point stepped = Clock::now();
+        if (renderer)
+            renderer->Render();
+        Clock::time_point rendered = Clock::now();
+        if (tick < scenario.warmupTicks)
+            continue;
+
+        measured++;
+        for (int s = 0; s < SIM_SYSTEM_COUNT; s++) {
+            systemSamples[s].push_back(sim->GetSystemSeconds(s));
+        }
+        stepSamples.push_back(chrono::duration<double>(stepped - start).count());
+        if (renderer)
+            renderSamples.push_back(chrono::duration<double>(rendered - stepped).count());
+        wallSeconds += chrono::duration<double>(rendered - start).count();
+        entityTicks += (double)sim->GetEnemies()->GetEnemyCount() + sim->GetBalls()->GetBulletCount();
+        enemyLod.Add(sim->GetEnemies()->GetLodStats());
+        hitCheckTicks += (double)sim->GetBalls()->GetHitCheckCount();
+        shotCheckTicks += (double)sim->GetBalls()->GetShotCheckCount();
+    }
+
+    json << "    {\n";
+    json << "      \"name\": " << JsonString(scenario.name) << ",\n";
+    json << "      \"ticks\": " << measured << ",\n";
+    json << "      \"hz\": " << scenario.tickRate << ",\n";
+    json << "      \"seed\": " << scenario.seed << ",\n";
+    json << "      \"threads\": " << sim->GetThreadCount() << ",\n";
+    json << "      \"rendered\": " << (renderer ? "true" : "false") << ",\n";
+    json << "      \"enemies\": " << sim->GetEnemies()->GetEnemyCount() << ",\n";
+    json << "      \"bullets\": " << sim->GetBalls()->GetBulletCount() << ",\n";
+    json << "      \"dropped_bullets\": " << sim->GetBalls()->GetDroppedBulletCount() << ",\n";
+    json << "      \"mean_entities\": " << (measured > 0 ? entityTicks / measured : 0.0) << ",\n";
+    json << "      \"mean_hit_checks\": " << (measured > 0 ? hitCheckTicks / measured : 0.0) << ",\n";
+    json << "      \"mean_shot_checks\": " << (measured > 0 ? shotCheckTicks / measured : 0.0) << ",\n";
+    json << "      \"systems\": {\n";
+    for (int s = 0; s < SIM_SYSTEM_COUNT; s++) {
+        WriteTimingJson(json, SimSystemName(s), systemSamples[s], false);
+    }
+    WriteTimingJson(json, "step", stepSamples, !renderer);
+    if (renderer)
+        WriteTimingJson(json, "render", renderSamples, true);
+    json << "      },\n";
+    json << "      \"lod\": {\n";
+    WriteLodJson(json, "enemies", enemyLod, measured, true);
+    json << "      },\n";
+    json << "      \"events\": {";
+    for (int e = 0; e < GAME_EVENT_COUNT; e++) {
+        json << (e > 0 ? ", " : " ") << JsonString(GameEventName(e)) << ": " << sim->GetEventTotal(e);
+    }
+    json << " },\n";
+    const BehaviorScheduler& behaviors = sim->GetEnemies()->GetBehaviors();
+    json << "      \"behaviors\": { \"running\": " << behaviors.GetRunningCount()
+        << ", \"pooled_frames\": " << behaviors.GetFramePool().GetCapacity()
+        << ", \"oversize_frames\": " << behaviors.GetFramePool().GetOversizeCount() << " },\n";
+    const SpawnDirector& director = sim->GetDirector();
+    const DirectorLimits& limits = director.GetLimits();
+    json << "      \"director\": { \"budget_ms\": " << director.GetBudgetSeconds() * 1000.0
+        << ", \"decisions\": " << director.GetStats().decisions << ", \"cuts\": " << director.GetStats().cuts
+        << ", \"relaxes\": " << director.GetStats().relaxes << ", \"last_frame_ms\": " << director.GetStats().lastFrameSeconds * 1000.0
+        << ", \"max_enemies\": " << limits.maxEnemies << ", \"max_health_packs\": " << limits.maxHealthPacks
+        << ", \"spawn_interval_scale\": " << limits.spawnIntervalScale << ", \"fire_interval_scale\": " << limits.fireIntervalScale << " },\n";
+    json << "      \"throughput\": { \"ticks_per_second\": " << (wallSeconds > 0.0 ? measured / wallSeconds : 0.0)
+        << ", \"sim_seconds_per_second\": " << (wallSeconds > 0.0 ? measured * (double)deltaTime / wallSeconds : 0.0)
+        << ", \"entity_updates_per_second\": " << (wallSeconds > 0.0 ? entityTicks / wallSeconds : 0.0) << " }\n";
+    json << "    }";
+
+    if (renderer)
+        renderer->End();
+    delete ownSim;
+}
+
+// Run every scenario of the given files and write one JSON report.
+// Options: --scenario FILE (repeatable), --out FILE (default stdout), --ticks N (override
+// every scenario), --threads N (override every scenario), --simd scalar|sse2|avx2,
+// --no-lod (turn every enemy every tick), --render (needs a renderer, i.e. the game
+// executable), --verbose (keep game log)
+int RunBenchmark(int argc, char** argv, BenchmarkRenderer* renderer = NULL) {
+    vector<BenchmarkScenario> scenarios;
+    const char* outPath = NULL;
+    bool render = false;
+    bool verbose = false;
+    long long ticksOverride = -1;
+    long long threadsOverride = -1;
+    bool noLod = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            if (!LoadBenchmarkScenarios(argv[++i], scenarios))
+                return 1;
+        }
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            ticksOverride = strtoll(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threadsOverride = strtoll(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            SimdLevel level;
+            if (!ParseSimdLevel(argv[++i], level)) {
+                cout << "Unknown SIMD level: " << argv[i] << endl;
+                return 1;
+            }
+            SetSimdLevel(level);
+        }
+        else if (strcmp(argv[i], "--no-lod") == 0)
+            noLod = true;
+        else if (strcmp(argv[i], "--render") == 0)
+            render = true;
+        else if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+    }
+    if (scenarios.empty()) {
+        cout << "Usage: --bench --scenario FILE [--scenario FILE...] [--out FILE] [--ticks N] [--render]" << endl;
+        return 1;
+    }
+    if (render && !renderer) {
+        cout << "--render needs the windowed game executable" << endl;
+        return 1;
+    }
+    if (ticksOverride >= 0) {
+        for (size_t i = 0; i < scenarios.size(); i++) {
+            scenarios[i].ticks = (unsigned long long)ticksOverride;
+        }
+    }
+    if (threadsOverride >= 0) {
+        for (size_t i = 0; i < scenarios.size(); i++) {
+            scenarios[i].config.workerThreads = (unsigned int)threadsOverride;
+        }
+    }
+    if (noLod) {
+        for (size_t i = 0; i < scenarios.size(); i++) {
+            scenarios[i].config.lodEnabled = false;
+        }
+    }
+
+    ostringstream json;
+    json << "{\n  \"simd\": " << JsonString(SimdLevelName(GetSimdLevel())) << ",\n  \"scenarios\": [\n";
+
+    // Per-event logging would dominate the run, mute it unless asked for
+    streambuf* coutBuffer = cout.rdbuf();
+    for (size_t i = 0; i < scenarios.size(); i++) {
+        cerr << "Scenario " << scenarios[i].name << " (" << i + 1 << "/" << scenarios.size() << ")" << endl;
+        if (!verbose)
+            cout.rdbuf(NULL);
+        RunBenchmarkScenario(scenarios[i], render ? renderer : NULL, json);
+        cout.rdbuf(coutBuffer);
+        cout.clear();
+        json << (i + 1 < scenarios.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+
+    if (outPath) {
+        ofstream out(outPath);
+        if (!out.is_open()) {
+            cout << "Could not write " << outPath << endl;
+            return 1;
+        }
+        out << json.str();
+    }
+    else {
+        cout << json.str();
+    }
+    return 0;
+}
+
+#endif // !BENCHMARK_H
@@ -0,0 +1,111 @@
+#ifndef BULLETGRID_H
+#define BULLETGRID_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+#include "bulletstore.h"
+#include "cellgrid.h"
+#include "jobsystem.h"
+#include "spatialgrid.h"
+
+const float BULLET_GRID_CELL = 4.0f;		// Cell edge of BulletGrid
+const size_t BULLET_GRID_CHUNK = 4096;		// Bullets per parallel chunk of Build
+
+// Bullets by floor cell at one moment. Every bullet moves every tick, so keeping a grid up
+// to date would cost as much as building it; Build files them afresh (CellBuckets). Cells
+// are numbered column by column (x column * cells per side + z row), so the bullets in
+// any stretch of one column are a single run of entries. Bullets off the arena are filed
+// under the nearest edge cell; queries test the exact distance, so results stay right
+// there, only slower.
+class BulletGrid {
+private:
+	float halfSize;
+	float cellSize;
+	int cellsPerSide;
+
+	CellBuckets buckets;				// Bullets (dense indices) by cell
+	vector<unsigned int> cellOf;		// Per bullet: its cell...
+	vector<vec3> bulletPos;				// ...and position
+	vector<vec3> positions;				// Per entry, sorted by cell: the bullet's position
+
+public:
+	BulletGrid(float halfSize = ARENA_HALF_SIZE, float cellSize = BULLET_GRID_CELL)
+		: halfSize(halfSize), cellSize(cellSize), cellsPerSide((int)ceil(2.0f * halfSize / cellSize)),
+		buckets((size_t)cellsPerSide * cellsPerSide) {}
+
+	// File every bullet of the store where it is at game time `time`
+	void Build(const BulletStore& bullets, double time, JobSystem* jobs) {
+		size_t count = bullets.Size();
+		cellOf.resize(count);
+		bulletPos.resize(count);
+		positions.resize(count);
+		ParallelFor(jobs, count, BULLET_GRID_CHUNK, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				vec3 p = bullets.Position(i, time);
+				bulletPos[i] = p;
+				cellOf[i] = (unsigned int)(CellCoord(p.x) * cellsPerSide + CellCoord(p.z));
+			}
+		});
+		buckets.Build(cellOf);
+		for (size_t i = 0; i < count; i++) {
+			positions[buckets.EntryOf(i)] = bulletPos[i];
+		}
+	}
+
+	// Call f(bullet index, distance along the ray) for every bullet within radius of the
+	// segment from origin along dir (unit length) for length. Visits the cells the
+	// segment crosses, one run of entries per column, each bullet at most once. Returns
+	// how many bullets were tested.
+	template <typename F>
+	size_t ForEachNearRay(vec3 origin, vec3 dir, float length, float radius, F f) const {
+		vec3 end = origin + dir * length;
+		int x0 = CellCoord(std::min(origin.x, end.x) - radius), x1 = CellCoord(std::max(origin.x, end.x) + radius);
+		float radiusSq = radius * radius;
+		size_t tested = 0;
+		for (int cx = x0; cx <= x1; cx++) {
+			// Part of the segment over this column widened by radius; the edge columns
+			// also hold everything beyond them
+			float slabMin = cx == 0 ? -INFINITY : -halfSize + cx * cellSize - radius;
+			float slabMax = cx == cellsPerSide - 1 ? INFINITY : -halfSize + (cx + 1) * cellSize + radius;
+			float t0 = 0.0f, t1 = length;
+			if (dir.x != 0.0f) {
+				float ta = (slabMin - origin.x) / dir.x, tb = (slabMax - origin.x) / dir.x;
+				t0 = std::max(t0, std::min(ta, tb));
+				t1 = std::min(t1, std::max(ta, tb));
+				if (t0 > t1)
+					continue;
+			}
+			else if (origin.x < slabMin || origin.x > slabMax) {
+				continue;
+			}
+			float za = origin.z + dir.z * t0, zb = origin.z + dir.z * t1;
+			int z0 = CellCoord(std::min(za, zb) - radius), z1 = CellCoord(std::max(za, zb) + radius);
+			size_t column = (size_t)cx * cellsPerSide;
+			unsigned int begin = buckets.Begin(column + z0), end = buckets.End(column + z1);
+			tested += end - begin;
+			for (unsigned int k = begin; k < end; k++) {
+				vec3 ap = positions[k] - origin;
+				float t = glm::clamp(dot(ap, dir), 0.0f, length);
+				vec3 d = ap - dir * t;
+				if (dot(d, d) <= radiusSq)
+					f((size_t)buckets.ItemOf(k), t);
+			}
+		}
+		return tested;
+	}
+
+	size_t Size() const {
+		return buckets.Size();
+	}
+
+private:
+	int CellCoord(float v) const {
+		return GridCellCoord(v, -halfSize, cellSize, cellsPerSide);
+	}
+};
+
+#endif // !BULLETGRID_H
@@ -0,0 +1,356 @@
+#ifndef BULLETSTORE_H
+#define BULLETSTORE_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <cmath>
+#include <vector>
+using namespace std;
+#include "simd.h"
+#include "slotpool.h"
+
+const double BULLET_REBASE_SECONDS = 60.0;	// Store times are re-based this often to keep float precision
+
+// Bullet spawn parameters. Live bullets are kept field-by-field in a BulletStore.
+struct Bullet {
+	vec3 position;		// Bullet position
+	vec3 direction;		// Bullet flight direction
+	float speed;		// Bullet speed
+	float lifetime;		// Bullet lifetime
+
+	// 动画相关
+	float frameDuration;   // 每帧的持续时间 (例如，0.1秒)
+
+	Bullet(glm::vec3 pos, glm::vec3 dir, float spd = 100.0f, float frameDur = 0.1f) // 增加了默认子弹速度和帧持续时间
+		: position(pos), direction(glm::normalize(dir)), speed(spd), lifetime(5.0f),
+		frameDuration(frameDur) {}
+};
+
+// One tick of the player's motion, for the hit-check kernels. Times are seconds on the
+// bullet store's clock (BulletStore::LocalTime).
+struct BulletSweep {
+	float from, to;		// The tick
+	vec3 start;			// Player position at `from`...
+	vec3 velocity;		// ...and its velocity over the tick
+	float radius;		// A bullet this close hits
+	float maxSpeed;		// Bound on the player's speed, for nextCheck
+};
+
+// Raw views of the bullets gathered for one hit check (BulletSweepBatch)
+struct BulletSweepLanes {
+	const float* originX;		// Where and when each bullet was fired...
+	const float* originY;
+	const float* originZ;
+	const float* velX;			// ...its velocity...
+	const float* velY;
+	const float* velZ;
+	const float* spawnTime;
+	const float* expireTime;	// ...and when it runs out
+	unsigned char* hit;			// Set to 1 when the bullet came within radius in the tick
+	float* nextCheck;			// Earliest time after the tick it could come within radius
+};
+
+// Closed-form hit test of bullets [begin, end) against the player over one tick. Both fly
+// straight over the part of the tick the bullet was alive, so the time of closest
+// approach of the two paths is exact whatever the tick length. Also bounds when each
+// bullet could reach the player next: from its distance at the end of the tick, closing
+// in at its speed plus the player's top speed.
+// Every level computes the same float operations in the same order.
+void SweepBulletLanesScalar(const BulletSweepLanes& b, size_t begin, size_t end, const BulletSweep& s) {
+	float radiusSq = s.radius * s.radius;
+	for (size_t i = begin; i < end; i++) {
+		float t0 = b.spawnTime[i] > s.from ? b.spawnTime[i] : s.from;
+		float t1 = b.expireTime[i] < s.to ? b.expireTime[i] : s.to;
+		// Bullet relative to the player: a at t0, moving at w
+		float age = t0 - b.spawnTime[i], since = t0 - s.from;
+		float ax = (b.originX[i] + b.velX[i] * age) - (s.start.x + s.velocity.x * since);
+		float ay = (b.originY[i] + b.velY[i] * age) - (s.start.y + s.velocity.y * since);
+		float az = (b.originZ[i] + b.velZ[i] * age) - (s.start.z + s.velocity.z * since);
+		float wx = b.velX[i] - s.velocity.x;
+		float wy = b.velY[i] - s.velocity.y;
+		float wz = b.velZ[i] - s.velocity.z;
+		float ww = wx * wx + wy * wy + wz * wz;
+		float aw = ax * wx + ay * wy + az * wz;
+		float span = t1 - t0;
+		float t = ww > 0.0f ? (0.0f - aw) / ww : 0.0f;
+		t = t < 0.0f ? 0.0f : (t > span ? span : t);
+		float cx = ax + wx * t, cy = ay + wy * t, cz = az + wz * t;
+		b.hit[i] = (span >= 0.0f && cx * cx + cy * cy + cz * cz <= radiusSq) ? 1 : 0;
+
+		float rest = s.to - t0;
+		float ex = ax + wx * rest, ey = ay + wy * rest, ez = az + wz * rest;
+		float distance = sqrt(ex * ex + ey * ey + ez * ez);
+		float speed = sqrt(b.velX[i] * b.velX[i] + b.velY[i] * b.velY[i] + b.velZ[i] * b.velZ[i]);
+		b.nextCheck[i] = s.to + (distance - s.radius) / (speed + s.maxSpeed);
+	}
+}
+
+#ifdef SIMD_X86
+void SweepBulletLanesSSE2(const BulletSweepLanes& b, size_t begin, size_t end, const BulletSweep& s) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 from = _mm_set1_ps(s.from), to = _mm_set1_ps(s.to);
+	const __m128 startX = _mm_set1_ps(s.start.x), startY = _mm_set1_ps(s.start.y), startZ = _mm_set1_ps(s.start.z);
+	const __m128 playerX = _mm_set1_ps(s.velocity.x), playerY = _mm_set1_ps(s.velocity.y), playerZ = _mm_set1_ps(s.velocity.z);
+	const __m128 radius = _mm_set1_ps(s.radius);
+	const __m128 radiusSq = _mm_set1_ps(s.radius * s.radius);
+	const __m128 maxSpeed = _mm_set1_ps(s.maxSpeed);
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 spawn = _mm_loadu_ps(b.spawnTime + i);
+		__m128 t0 = _mm_max_ps(spawn, from);
+		__m128 t1 = _mm_min_ps(_mm_loadu_ps(b.expireTime + i), to);
+		__m128 age = _mm_sub_ps(t0, spawn), since = _mm_sub_ps(t0, from);
+		__m128 vx = _mm_loadu_ps(b.velX + i), vy = _mm_loadu_ps(b.velY + i), vz = _mm_loadu_ps(b.velZ + i);
+		__m128 ax = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(b.originX + i), _mm_mul_ps(vx, age)), _mm_add_ps(startX, _mm_mul_ps(playerX, since)));
+		__m128 ay = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(b.originY + i), _mm_mul_ps(vy, age)), _mm_add_ps(startY, _mm_mul_ps(playerY, since)));
+		__m128 az = _mm_sub_ps(_mm_add_ps(_mm_loadu_ps(b.originZ + i), _mm_mul_ps(vz, age)), _mm_add_ps(startZ, _mm_mul_ps(playerZ, since)));
+		__m128 wx = _mm_sub_ps(vx, playerX), wy = _mm_sub_ps(vy, playerY), wz = _mm_sub_ps(vz, playerZ);
+		__m128 ww = _mm_add_ps(_mm_add_ps(_mm_mul_ps(wx, wx), _mm_mul_ps(wy, wy)), _mm_mul_ps(wz, wz));
+		__m128 aw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, wx), _mm_mul_ps(ay, wy)), _mm_mul_ps(az, wz));
+		__m128 span = _mm_sub_ps(t1, t0);
+		__m128 t = _mm_and_ps(_mm_cmpgt_ps(ww, zero), _mm_div_ps(_mm_sub_ps(zero, aw), ww));
+		t = _mm_min_ps(_mm_max_ps(t, zero), span);
+		__m128 cx = _mm_add_ps(ax, _mm_mul_ps(wx, t));
+		__m128 cy = _mm_add_ps(ay, _mm_mul_ps(wy, t));
+		__m128 cz = _mm_add_ps(az, _mm_mul_ps(wz, t));
+		__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz));
+		int hit = _mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(span, zero), _mm_cmple_ps(distSq, radiusSq)));
+		for (int k = 0; k < 4; k++) {
+			b.hit[i + k] = (unsigned char)((hit >> k) & 1);
+		}
+
+		__m128 rest = _mm_sub_ps(to, t0);
+		__m128 ex = _mm_add_ps(ax, _mm_mul_ps(wx, rest));
+		__m128 ey = _mm_add_ps(ay, _mm_mul_ps(wy, rest));
+		__m128 ez = _mm_add_ps(az, _mm_mul_ps(wz, rest));
+		__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez)));
+		__m128 speed = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+		_mm_storeu_ps(b.nextCheck + i, _mm_add_ps(to, _mm_div_ps(_mm_sub_ps(distance, radius), _mm_add_ps(speed, maxSpeed))));
+	}
+	SweepBulletLanesScalar(b, i, end, s);
+}
+
+SIMD_TARGET_AVX2
+void SweepBulletLanesAVX2(const BulletSweepLanes& b, size_t begin, size_t end, const BulletSweep& s) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 from = _mm256_set1_ps(s.from), to = _mm256_set1_ps(s.to);
+	const __m256 startX = _mm256_set1_ps(s.start.x), startY = _mm256_set1_ps(s.start.y), startZ = _mm256_set1_ps(s.start.z);
+	const __m256 playerX = _mm256_set1_ps(s.velocity.x), playerY = _mm256_set1_ps(s.velocity.y), playerZ = _mm256_set1_ps(s.velocity.z);
+	const __m256 radius = _mm256_set1_ps(s.radius);
+	const __m256 radiusSq = _mm256_set1_ps(s.radius * s.radius);
+	const __m256 maxSpeed = _mm256_set1_ps(s.maxSpeed);
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 spawn = _mm256_loadu_ps(b.spawnTime + i);
+		__m256 t0 = _mm256_max_ps(spawn, from);
+		__m256 t1 = _mm256_min_ps(_mm256_loadu_ps(b.expireTime + i), to);
+		__m256 age = _mm256_sub_ps(t0, spawn), since = _mm256_sub_ps(t0, from);
+		__m256 vx = _mm256_loadu_ps(b.velX + i), vy = _mm256_loadu_ps(b.velY + i), vz = _mm256_loadu_ps(b.velZ + i);
+		__m256 ax = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(b.originX + i), _mm256_mul_ps(vx, age)), _mm256_add_ps(startX, _mm256_mul_ps(playerX, since)));
+		__m256 ay = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(b.originY + i), _mm256_mul_ps(vy, age)), _mm256_add_ps(startY, _mm256_mul_ps(playerY, since)));
+		__m256 az = _mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(b.originZ + i), _mm256_mul_ps(vz, age)), _mm256_add_ps(startZ, _mm256_mul_ps(playerZ, since)));
+		__m256 wx = _mm256_sub_ps(vx, playerX), wy = _mm256_sub_ps(vy, playerY), wz = _mm256_sub_ps(vz, playerZ);
+		__m256 ww = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(wx, wx), _mm256_mul_ps(wy, wy)), _mm256_mul_ps(wz, wz));
+		__m256 aw = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, wx), _mm256_mul_ps(ay, wy)), _mm256_mul_ps(az, wz));
+		__m256 span = _mm256_sub_ps(t1, t0);
+		__m256 t = _mm256_and_ps(_mm256_cmp_ps(ww, zero, _CMP_GT_OQ), _mm256_div_ps(_mm256_sub_ps(zero, aw), ww));
+		t = _mm256_min_ps(_mm256_max_ps(t, zero), span);
+		__m256 cx = _mm256_add_ps(ax, _mm256_mul_ps(wx, t));
+		__m256 cy = _mm256_add_ps(ay, _mm256_mul_ps(wy, t));
+		__m256 cz = _mm256_add_ps(az, _mm256_mul_ps(wz, t));
+		__m256 distSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, cx), _mm256_mul_ps(cy, cy)), _mm256_mul_ps(cz, cz));
+		int hit = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(span, zero, _CMP_GE_OQ), _mm256_cmp_ps(distSq, radiusSq, _CMP_LE_OQ)));
+		for (int k = 0; k < 8; k++) {
+			b.hit[i + k] = (unsigned char)((hit >> k) & 1);
+		}
+
+		__m256 rest = _mm256_sub_ps(to, t0);
+		__m256 ex = _mm256_add_ps(ax, _mm256_mul_ps(wx, rest));
+		__m256 ey = _mm256_add_ps(ay, _mm256_mul_ps(wy, rest));
+		__m256 ez = _mm256_add_ps(az, _mm256_mul_ps(wz, rest));
+		__m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey)), _mm256_mul_ps(ez, ez)));
+		__m256 speed = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz)));
+		_mm256_storeu_ps(b.nextCheck + i, _mm256_add_ps(to, _mm256_div_ps(_mm256_sub_ps(distance, radius), _mm256_add_ps(speed, maxSpeed))));
+	}
+	SweepBulletLanesScalar(b, i, end, s);
+}
+#endif
+
+void SweepBulletLanes(const BulletSweepLanes& b, size_t begin, size_t end, const BulletSweep& s) {
+#ifdef SIMD_X86
+	switch (GetSimdLevel()) {
+	case SIMD_AVX2:
+		SweepBulletLanesAVX2(b, begin, end, s);
+		return;
+	case SIMD_SSE2:
+		SweepBulletLanesSSE2(b, begin, end, s);
+		return;
+	default:
+		break;
+	}
+#endif
+	SweepBulletLanesScalar(b, begin, end, s);
+}
+
+// Bullets copied out of the store for one hit check, so the kernel streams through them
+class BulletSweepBatch {
+private:
+	vector<float> originX, originY, originZ;
+	vector<float> velX, velY, velZ;
+	vector<float> spawnTime, expireTime;
+	vector<unsigned char> hit;
+	vector<float> nextCheck;
+
+	friend class BulletStore;
+
+public:
+	size_t Size() const { return hit.size(); }
+	bool Hit(size_t i) const { return hit[i] != 0; }
+	float NextCheck(size_t i) const { return nextCheck[i]; }	// Store time
+
+	BulletSweepLanes Lanes() {
+		BulletSweepLanes lanes;
+		lanes.originX = originX.data(); lanes.originY = originY.data(); lanes.originZ = originZ.data();
+		lanes.velX = velX.data(); lanes.velY = velY.data(); lanes.velZ = velZ.data();
+		lanes.spawnTime = spawnTime.data();
+		lanes.expireTime = expireTime.data();
+		lanes.hit = hit.data();
+		lanes.nextCheck = nextCheck.data();
+		return lanes;
+	}
+
+private:
+	void Resize(size_t n) {
+		originX.resize(n); originY.resize(n); originZ.resize(n);
+		velX.resize(n); velY.resize(n); velZ.resize(n);
+		spawnTime.resize(n); expireTime.resize(n);
+		hit.resize(n);
+		nextCheck.resize(n);
+	}
+};
+
+// Structure-of-arrays bullet storage. A bullet flies straight at constant speed, so it is
+// kept as where and when it was fired plus its velocity, and its position is worked out
+// when asked for: nothing is updated per tick. Times are floats relative to an epoch the
+// owner moves forward now and then (Rebase), so they stay precise however long the game
+// runs. Capacity is fixed at construction; removal is swap-and-pop and handles are
+// generational (see SlotIndex).
+class BulletStore {
+private:
+	SlotIndex slots;
+	double epoch;						// Store time 0 in game seconds
+
+	vector<float> originX, originY, originZ;	// Position at spawnTime
+	vector<float> velX, velY, velZ;		// direction * speed
+	vector<float> spawnTime;
+	vector<float> expireTime;			// Lifetime or range ran out
+	vector<float> frameDuration;		// Animation
+
+public:
+	BulletStore(size_t capacity) : slots(capacity), epoch(0.0),
+		originX(capacity), originY(capacity), originZ(capacity),
+		velX(capacity), velY(capacity), velZ(capacity),
+		spawnTime(capacity), expireTime(capacity), frameDuration(capacity) {}
+
+	// Fire a bullet at game time `time`. It expires after its lifetime or when it gets
+	// further than maxRange from the origin, whichever comes first.
+	// Returns an invalid handle when the store is full.
+	PoolHandle Add(const Bullet& bullet, double time, float maxRange) {
+		PoolHandle handle = slots.Add();
+		if (!handle.IsValid())
+			return handle;
+		size_t i = slots.Size() - 1;
+		vec3 velocity = bullet.direction * bullet.speed;
+		originX[i] = bullet.position.x; originY[i] = bullet.position.y; originZ[i] = bullet.position.z;
+		velX[i] = velocity.x; velY[i] = velocity.y; velZ[i] = velocity.z;
+		spawnTime[i] = LocalTime(time);
+		expireTime[i] = spawnTime[i] + std::min(bullet.lifetime, TimeToLeave(bullet.position, velocity, maxRange));
+		frameDuration[i] = bullet.frameDuration;
+		return handle;
+	}
+
+	// Remove bullet i; the last bullet moves into i
+	void RemoveAt(size_t i) {
+		size_t last = slots.RemoveAt(i);
+		if (i == last)
+			return;
+		originX[i] = originX[last]; originY[i] = originY[last]; originZ[i] = originZ[last];
+		velX[i] = velX[last]; velY[i] = velY[last]; velZ[i] = velZ[last];
+		spawnTime[i] = spawnTime[last];
+		expireTime[i] = expireTime[last];
+		frameDuration[i] = frameDuration[last];
+	}
+
+	bool Remove(PoolHandle handle) {
+		if (!slots.Contains(handle))
+			return false;
+		RemoveAt(slots.IndexOf(handle));
+		return true;
+	}
+
+	// Move the epoch up to `time` once it has fallen BULLET_REBASE_SECONDS behind
+	void Rebase(double time) {
+		if (time - epoch < BULLET_REBASE_SECONDS)
+			return;
+		float shift = LocalTime(time);
+		for (size_t i = 0; i < slots.Size(); i++) {
+			spawnTime[i] -= shift;
+			expireTime[i] -= shift;
+		}
+		epoch += shift;
+	}
+
+	// Game time <-> store time
+	float LocalTime(double time) const { return (float)(time - epoch); }
+	double GameTime(float localTime) const { return epoch + localTime; }
+
+	// Copy the bullets of handles (all live) into batch for SweepBulletLanes
+	void Gather(const vector<PoolHandle>& handles, BulletSweepBatch& batch) const {
+		batch.Resize(handles.size());
+		for (size_t k = 0; k < handles.size(); k++) {
+			size_t i = slots.IndexOf(handles[k]);
+			batch.originX[k] = originX[i]; batch.originY[k] = originY[i]; batch.originZ[k] = originZ[i];
+			batch.velX[k] = velX[i]; batch.velY[k] = velY[i]; batch.velZ[k] = velZ[i];
+			batch.spawnTime[k] = spawnTime[i];
+			batch.expireTime[k] = expireTime[i];
+		}
+	}
+
+	// Position at game time `time`; bullets stay at the muzzle until they are fired
+	vec3 Position(size_t i, double time) const {
+		float age = std::max(0.0f, LocalTime(time) - spawnTime[i]);
+		return vec3(originX[i] + velX[i] * age, originY[i] + velY[i] * age, originZ[i] + velZ[i] * age);
+	}
+	// Animation frame at game time `time`, out of numFrames
+	int FrameIndex(size_t i, double time, int numFrames) const {
+		float age = std::max(0.0f, LocalTime(time) - spawnTime[i]);
+		return numFrames > 0 ? (int)(age / frameDuration[i]) % numFrames : 0;
+	}
+	vec3 Velocity(size_t i) const { return vec3(velX[i], velY[i], velZ[i]); }
+	double ExpireTime(size_t i) const { return GameTime(expireTime[i]); }
+
+	bool Contains(PoolHandle handle) const { return slots.Contains(handle); }
+	size_t IndexOf(PoolHandle handle) const { return slots.IndexOf(handle); }
+	size_t IndexOfSlot(unsigned int slot) const { return slots.IndexOfSlot(slot); }
+	PoolHandle HandleAt(size_t i) const { return slots.HandleAt(i); }
+	size_t Size() const { return slots.Size(); }
+	size_t Capacity() const { return slots.Capacity(); }
+	bool Full() const { return slots.Full(); }
+
+private:
+	// Seconds until pos + velocity * t first gets further than range from the origin; 0 if
+	// it already is
+	static float TimeToLeave(vec3 pos, vec3 velocity, float range) {
+		float a = dot(velocity, velocity);
+		float b = dot(pos, velocity);
+		float c = dot(pos, pos) - range * range;
+		if (c > 0.0f)
+			return 0.0f;
+		if (a <= 0.0f)
+			return INFINITY;
+		// Larger root of a t^2 + 2 b t + c = 0, c <= 0 so it is not negative
+		return (-b + sqrt(b * b - a * c)) / a;
+	}
+};
+
+#endif // !BULLETSTORE_H
@@ -1,10 +1,12 @@
 ﻿#ifndef CAMERA_H
 #define CAMERA_H
 
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 using namespace glm;
+#include "inputstate.h"
+#include "spatialgrid.h"
+#include "staticbvh.h"
 
 const float YAW = -90.0f;			
 const float PITCH = 0.0f;			
@@ -15,11 +17,13 @@ const float ZOOM = 45.0f;
 const float JUMPTIME = 0.1f;		
 const float GRAVITY = 9.8f;			
 const float JUMPSTRENGTH = 60.0f;	
+const float PLAYER_RADIUS = 2.0f;	// Body capsule against the room, from this far below the eye...
+const float PLAYER_STEP_HEIGHT = 4.0f;	// ...down to this above the feet, so floors and low steps are free
+const int PLAYER_COLLISION_PASSES = 4;	// Push-outs per check, deepest contact first
+const float PLAYER_MAX_STEP = PLAYER_RADIUS * 0.5f;	// Longest walk between two collision checks
 
 class Camera {
 private:
-	GLFWwindow* window;
-
 	vec3 position;				
 	vec3 front;					
 	vec3 right;					
@@ -37,17 +41,12 @@ private:
 	float mouseSensitivity;		
 	float zoom;					
 
-	double mouseX;
-	double mouseY;
-	bool firstMouse;			
+	const StaticBVH* world;		// Room the body collides with, may be NULL
 public:
-	Camera(GLFWwindow* window) {
-		this->window = window;
-
+	Camera() {
 		movementSpeed = SPEED;
 		mouseSensitivity = SENSITIVITY;
 		zoom = ZOOM;
-		firstMouse = true;
 
 		jumpTimer = 0;
 		isJump = false;
@@ -57,54 +56,60 @@ public:
 		worldUp = vec3(0.0f, 1.0f, 0.0f);
 		yaw = YAW;
 		pitch = PITCH;
+		world = NULL;
 
 		UpdateCamera();
 	}	
-	void Update(float deltaTime) {
-		MouseMovement();
-		KeyboardInput(deltaTime);
+
+	// Collide with these triangles from now on (NULL: only the arena bounds)
+	void SetWorld(const StaticBVH* world) {
+		this->world = world;
+		CheckCollision();
 	}
 
-	mat4 GetViewMatrix() {
+	void Update(float deltaTime, const InputState& input) {
+		MouseMovement(input);
+		KeyboardInput(deltaTime, input);
+	}
+
+	mat4 GetViewMatrix() const {
 		return lookAt(position, position + front, up);
 	}
 
-	vec3 GetPosition() {
+	vec3 GetPosition() const {
 		return position;
 	}
 
-	vec3 GetFront() {
+	vec3 GetFront() const {
 		return front;
 	}
 
-	vec3 GetRight() {
+	vec3 GetRight() const {
 		return right;
 	}
 
-	vec3 GetUp() {
+	vec3 GetUp() const {
 		return up;
 	}
 
-	float GetZoom() {
+	float GetZoom() const {
 		return zoom;
 	}
+
+	// Become the view a fraction t of the way from one simulated state to the next,
+	// for drawing between ticks
+	void Interpolate(const Camera& from, const Camera& to, float t) {
+		*this = to;
+		position = mix(from.position, to.position, t);
+		yaw = mix(from.yaw, to.yaw, t);
+		pitch = mix(from.pitch, to.pitch, t);
+		UpdateCamera();
+	}
 private:
 	// �������
-	void MouseMovement() {
-		double newMouseX, newMouseY;
-
-		glfwGetCursorPos(window, &newMouseX, &newMouseY);
-		if (firstMouse) {
-			mouseX = newMouseX;
-			mouseY = newMouseY;
-			firstMouse = false;
-		}
-
-		yaw += ((newMouseX - mouseX) * mouseSensitivity);
-		pitch += ((mouseY - newMouseY) * mouseSensitivity);
-
-		mouseX = newMouseX;
-		mouseY = newMouseY;
+	void MouseMovement(const InputState& input) {
+		yaw += input.mouseDX * mouseSensitivity;
+		pitch -= input.mouseDY * mouseSensitivity;
 
 		if (pitch > 89.0f)
 			pitch = 89.0f;
@@ -115,19 +120,20 @@ private:
 		UpdateCamera();
 	}
 	// ��������
-	void KeyboardInput(float deltaTime) {
+	void KeyboardInput(float deltaTime, const InputState& input) {
 		float velocity = movementSpeed * deltaTime;
 		vec3 forward = normalize(cross(worldUp, right));
-		if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-			position += forward * velocity;
-		if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-			position -= forward * velocity;
-		if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-			position -= right * velocity;
-		if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-			position += right * velocity;
-
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS && !isJump) {
+		vec3 walk(0.0f);
+		if (input.forward)
+			walk += forward * velocity;
+		if (input.back)
+			walk -= forward * velocity;
+		if (input.left)
+			walk -= right * velocity;
+		if (input.right)
+			walk += right * velocity;
+
+		if (input.jump && !isJump) {
 			jumpTimer = JUMPTIME;
 			isJump = true;
 		}
@@ -144,18 +150,43 @@ private:
 			isJump = false;
 		}
 
-		CheckCollision();
+		// Walk in steps short enough that the body is still in front of a wall when it
+		// touches it, however long the tick (a low --hz)
+		int steps = (int)ceil(length(walk) / PLAYER_MAX_STEP);
+		if (steps < 1)
+			steps = 1;
+		for (int s = 0; s < steps; s++) {
+			position += walk / (float)steps;
+			CheckCollision();
+		}
 	}
 	// ��ײ���
+	// Keep to the arena, then push the body capsule out of the room's walls sideways,
+	// deepest contact first. The body must not have moved more than PLAYER_MAX_STEP since
+	// the last check, or it may already be past a thin wall and get pushed out behind it.
 	void CheckCollision() {
-		if (position.x > 180.0f)
-			position.x = 180.0f;
-		if (position.x < -180.0f)
-			position.x = -90.0f;
-		if (position.z > 180.0f)
-			position.z = 180.0f;
-		if (position.z < -180.0f)
-			position.z = -180.0f;
+		position.x = glm::clamp(position.x, -ARENA_HALF_SIZE, ARENA_HALF_SIZE);
+		position.z = glm::clamp(position.z, -ARENA_HALF_SIZE, ARENA_HALF_SIZE);
+		if (!world)
+			return;
+		for (int pass = 0; pass < PLAYER_COLLISION_PASSES; pass++) {
+			vec3 feet = position - vec3(0.0f, HEIGHT - PLAYER_STEP_HEIGHT - PLAYER_RADIUS, 0.0f);
+			float depth = 0.0f;
+			vec2 away(0.0f);
+			world->CapsuleContacts(feet, position, PLAYER_RADIUS, [&](const StaticContact& contact) {
+				vec3 out = contact.distance > 0.0f ? (contact.onSegment - contact.onTriangle) / contact.distance : contact.normal;
+				vec2 side(out.x, out.z);
+				float sideLength = length(side);
+				if (sideLength < 0.1f || PLAYER_RADIUS - contact.distance <= depth)
+					return;	// Floor or ceiling, or not the deepest
+				depth = PLAYER_RADIUS - contact.distance;
+				away = side / sideLength;
+			});
+			if (depth <= 0.0f)
+				break;
+			position.x += away.x * depth;
+			position.z += away.y * depth;
+		}
 	}
 	// ��������ͷ���������
 	void UpdateCamera() {
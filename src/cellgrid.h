@@ -0,0 +1,65 @@
+#ifndef CELLGRID_H
+#define CELLGRID_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+
+// Shared pieces of the square floor grids (SpatialGrid, NeighbourGrid, BulletGrid,
+// FlowField, SpawnZone).
+
+// Cell of coordinate v on an axis of cellsPerSide cells of cellSize starting at minCoord.
+// Values off the grid, however far, fall in the edge cells.
+inline int GridCellCoord(float v, float minCoord, float cellSize, int cellsPerSide) {
+    float c = floor((v - minCoord) / cellSize);
+    return c < 0.0f ? 0 : (c >= (float)cellsPerSide ? cellsPerSide - 1 : (int)c);
+}
+
+// Items filed by cell with a counting sort, rebuilt from scratch: the entries of cell c
+// are [Begin(c), End(c)), in item order within a cell. Grids keep their per-entry data
+// (positions and so on) in arrays of their own, indexed by entry.
+class CellBuckets {
+private:
+    vector<unsigned int> cellStart; // Per cell: first entry; one extra for the end
+    vector<unsigned int> entryOf;   // Per item: its entry
+    vector<unsigned int> itemOf;    // Per entry: its item
+
+public:
+    CellBuckets(size_t cellCount, size_t capacity = 0) : cellStart(cellCount + 1, 0u) {
+        entryOf.reserve(capacity);
+        itemOf.reserve(capacity);
+    }
+
+    // File items 0 .. cellOf.size() - 1, item i under cell cellOf[i]
+    void Build(const vector<unsigned int>& cellOf) {
+        size_t count = cellOf.size();
+        entryOf.resize(count);
+        itemOf.resize(count);
+        fill(cellStart.begin(), cellStart.end(), 0u);
+        for (size_t i = 0; i < count; i++) {
+            cellStart[cellOf[i] + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); c++) {
+            cellStart[c] += cellStart[c - 1];
+        }
+        // Scatter, counting each cell's start up as it fills; shift back afterwards
+        for (size_t i = 0; i < count; i++) {
+            unsigned int k = cellStart[cellOf[i]]++;
+            entryOf[i] = k;
+            itemOf[k] = (unsigned int)i;
+        }
+        for (size_t c = cellStart.size() - 1; c > 0; c--) {
+            cellStart[c] = cellStart[c - 1];
+        }
+        cellStart[0] = 0;
+    }
+
+    unsigned int Begin(size_t cell) const { return cellStart[cell]; }
+    unsigned int End(size_t cell) const { return cellStart[cell + 1]; }
+    unsigned int EntryOf(size_t item) const { return entryOf[item]; }
+    unsigned int ItemOf(size_t entry) const { return itemOf[entry]; }
+    size_t Size() const { return itemOf.size(); }
+};
+
+#endif // !CELLGRID_H
@@ -0,0 +1,123 @@
+#ifndef DIRECTOR_H
+#define DIRECTOR_H
+
+#include <algorithm>
+using namespace std;
+#include "simconfig.h"
+
+const double DIRECTOR_PERIOD = 1.0;         // Game seconds between decisions
+const double DIRECTOR_HEADROOM = 0.75;      // Frames below this share of the budget ease the limits
+const double DIRECTOR_BULLET_SHARE = 0.25;  // Fire slows too when bullets take this share of the step
+const float DIRECTOR_SLOWDOWN = 1.5f;       // Interval scales grow by this over budget...
+const float DIRECTOR_RECOVERY = 1.25f;      // ...and shrink back by this under the headroom
+const float DIRECTOR_MAX_SCALE = 4.0f;      // Intervals stretch at most this much
+const unsigned int DIRECTOR_RELAX_STEPS = 20;   // Caps grow back by this fraction of the configured one
+
+// What the director lets the game spawn. Starts at the configured caps and pace.
+struct DirectorLimits {
+    unsigned int maxEnemies;        // Spawning waits above this many
+    unsigned int maxHealthPacks;
+    float spawnIntervalScale;       // Enemy and health pack spawn intervals times this
+    float fireIntervalScale;        // Shooters' fire intervals times this
+
+    DirectorLimits() : maxEnemies(0), maxHealthPacks(0), spawnIntervalScale(1.0f), fireIntervalScale(1.0f) {}
+    DirectorLimits(const SimConfig& config)
+        : maxEnemies(config.maxEnemies), maxHealthPacks(config.maxHealthPacks), spawnIntervalScale(1.0f), fireIntervalScale(1.0f) {}
+
+    bool operator==(const DirectorLimits& other) const {
+        return maxEnemies == other.maxEnemies && maxHealthPacks == other.maxHealthPacks
+            && spawnIntervalScale == other.spawnIntervalScale && fireIntervalScale == other.fireIntervalScale;
+    }
+    bool operator!=(const DirectorLimits& other) const { return !(*this == other); }
+};
+
+// Decisions so far, for telemetry
+struct DirectorStats {
+    unsigned long long decisions;   // Periods judged
+    unsigned long long cuts;        // ...that were over budget and tightened the limits
+    unsigned long long relaxes;     // ...that had headroom and eased them
+    double lastFrameSeconds;        // Mean frame cost of the last period judged
+
+    DirectorStats() : decisions(0), cuts(0), relaxes(0), lastFrameSeconds(0.0) {}
+};
+
+// Holds a frame budget by pacing spawns. The game reports every tick's measured cost
+// (simulation step, the share of it spent on bullets, and rendering); once a period, the
+// director compares the mean frame with the budget. Over it, the entity caps drop to the
+// live count scaled by budget/cost, spawns slow down, and so does fire if bullets are a
+// big part of the step. With headroom, caps and pace creep back to the configured ones.
+// Decisions depend on wall time, so a recording stores the limits (InputRecorder) and a
+// replay sets them instead of running the director.
+class SpawnDirector {
+private:
+    double budget;                  // Seconds per frame, 0: off
+    DirectorLimits configured;      // Limits never go above these
+    DirectorLimits limits;
+    double nextDecision;            // Game time
+    double stepSum, bulletSum, renderSum;   // Seconds measured since the last decision...
+    unsigned int frames;            // ...over this many ticks
+    DirectorStats stats;
+
+public:
+    SpawnDirector(const SimConfig& config)
+        : budget(config.frameBudgetMs / 1000.0), configured(config), limits(config), nextDecision(DIRECTOR_PERIOD),
+        stepSum(0.0), bulletSum(0.0), renderSum(0.0), frames(0) {}
+
+    bool IsEnabled() const { return budget > 0.0; }
+
+    // Stop deciding; the limits stay as they are
+    void Disable() { budget = 0.0; }
+
+    // One tick's measured cost
+    void AddFrame(double stepSeconds, double bulletSeconds, double renderSeconds) {
+        stepSum += stepSeconds;
+        bulletSum += bulletSeconds;
+        renderSum += renderSeconds;
+        frames++;
+    }
+
+    // Judge the ticks since the last decision once a period has passed, given the live
+    // entity counts. Returns true when the limits changed.
+    bool Decide(double gameTime, size_t enemies, size_t healthPacks) {
+        if (!IsEnabled() || gameTime < nextDecision || frames == 0)
+            return false;
+        nextDecision = gameTime + DIRECTOR_PERIOD;
+        double frame = (stepSum + renderSum) / frames;
+        double bulletShare = stepSum > 0.0 ? bulletSum / stepSum : 0.0;
+        stepSum = bulletSum = renderSum = 0.0;
+        frames = 0;
+        stats.decisions++;
+        stats.lastFrameSeconds = frame;
+
+        DirectorLimits next = limits;
+        if (frame > budget) {
+            // Every system and draw call scales with the entities: hold them to what fits
+            double keep = budget / frame;
+            next.maxEnemies = std::max(1u, std::min(next.maxEnemies, (unsigned int)(enemies * keep)));
+            next.maxHealthPacks = std::max(1u, std::min(next.maxHealthPacks, (unsigned int)(healthPacks * keep)));
+            next.spawnIntervalScale = std::min(DIRECTOR_MAX_SCALE, next.spawnIntervalScale * DIRECTOR_SLOWDOWN);
+            if (bulletShare >= DIRECTOR_BULLET_SHARE)
+                next.fireIntervalScale = std::min(DIRECTOR_MAX_SCALE, next.fireIntervalScale * DIRECTOR_SLOWDOWN);
+        }
+        else if (frame < budget * DIRECTOR_HEADROOM) {
+            next.maxEnemies = std::min(configured.maxEnemies, next.maxEnemies + std::max(1u, configured.maxEnemies / DIRECTOR_RELAX_STEPS));
+            next.maxHealthPacks = std::min(configured.maxHealthPacks, next.maxHealthPacks + std::max(1u, configured.maxHealthPacks / DIRECTOR_RELAX_STEPS));
+            next.spawnIntervalScale = std::max(1.0f, next.spawnIntervalScale / DIRECTOR_RECOVERY);
+            next.fireIntervalScale = std::max(1.0f, next.fireIntervalScale / DIRECTOR_RECOVERY);
+        }
+        if (next == limits)
+            return false;
+        if (frame > budget)
+            stats.cuts++;
+        else
+            stats.relaxes++;
+        limits = next;
+        return true;
+    }
+
+    const DirectorLimits& GetLimits() const { return limits; }
+    const DirectorStats& GetStats() const { return stats; }
+    double GetBudgetSeconds() const { return budget; }
+};
+
+#endif // !DIRECTOR_H
@@ -0,0 +1,367 @@
+#ifndef DYNAMICBVH_H
+#define DYNAMICBVH_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+
+struct AABB {
+    vec3 min;
+    vec3 max;
+
+    AABB() : min(0.0f), max(0.0f) {}
+    AABB(vec3 min, vec3 max) : min(min), max(max) {}
+
+    bool Contains(const AABB& other) const {
+        return all(lessThanEqual(min, other.min)) && all(greaterThanEqual(max, other.max));
+    }
+    float SurfaceArea() const {
+        vec3 d = max - min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    static AABB Union(const AABB& a, const AABB& b) {
+        return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+    }
+};
+
+// Distance along a ray to where it enters the box, or -1 when it misses within maxT.
+// invDir is 1/dir per axis (infinite for zero components).
+inline float RayEnterAABB(vec3 origin, vec3 invDir, float maxT, const AABB& box) {
+    vec3 t0 = (box.min - origin) * invDir;
+    vec3 t1 = (box.max - origin) * invDir;
+    vec3 tNear = glm::min(t0, t1), tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+    return enter <= exit ? enter : -1.0f;
+}
+
+// Incrementally updated bounding volume hierarchy for moving objects. Leaves hold a
+// caller-chosen id (a stable slot) and a box fattened by a margin, so small moves do not
+// touch the tree. Insertion picks the sibling with the least surface-area growth, and
+// refits rotate grandchildren up where that shrinks a node, so the tree stays shallow
+// while many objects keep moving. A leaf moved out of its box grows in place instead of
+// being re-inserted (cheap, and still a bound for queries); Rebalance re-inserts the
+// grown leaves a budget at a time, so a crowd leaving its boxes on the same tick does
+// not rebuild half the tree at once.
+// Inner nodes keep copies of both child boxes so a ray tests the pair from one node.
+class DynamicBVH {
+private:
+    struct Node {
+        AABB childBox[2];   // Copies of the children's boxes, inner nodes only
+        int child[2];       // -1 for leaves
+        int parent;
+        int id;             // Leaf payload, -1 for inner nodes
+        AABB box;           // Own box (fattened for leaves)
+        bool grown;         // Leaf grown by Move, waiting for Rebalance
+
+        bool IsLeaf() const { return child[0] < 0; }
+    };
+    struct StackEntry {
+        int node;
+        float enter;        // Where the ray enters its box
+    };
+
+    vector<Node> nodes;
+    vector<int> freeNodes;
+    vector<int> leafOf;         // Per id: its leaf node, -1 when not in the tree
+    vector<AABB> leafBoxes;     // Per id: copy of its leaf's box, so Fits reads one array
+    int root;
+    float margin;
+    size_t count;
+    mutable vector<StackEntry> stack;   // Traversal scratch
+    vector<unsigned int> grownIds;      // Ids of grown leaves, oldest first from grownHead
+    size_t grownHead;
+
+public:
+    DynamicBVH(float margin = 1.0f) : root(-1), margin(margin), count(0), grownHead(0) {}
+
+    // Add id with the given tight box; re-inserts if already present
+    void Insert(unsigned int id, const AABB& box) {
+        if (id >= leafOf.size()) {
+            leafOf.resize(std::max((size_t)id + 1, leafOf.size() * 2), -1);
+            leafBoxes.resize(leafOf.size());
+        }
+        if (leafOf[id] >= 0)
+            Remove(id);
+        int leaf = AllocateNode();
+        nodes[leaf].box = AABB(box.min - vec3(margin), box.max + vec3(margin));
+        nodes[leaf].id = (int)id;
+        InsertLeaf(leaf);
+        leafOf[id] = leaf;
+        leafBoxes[id] = nodes[leaf].box;
+        count++;
+    }
+
+    void Remove(unsigned int id) {
+        if (id >= leafOf.size() || leafOf[id] < 0)
+            return;
+        int leaf = leafOf[id];
+        RemoveLeaf(leaf);
+        FreeNode(leaf);
+        leafOf[id] = -1;
+        count--;
+    }
+
+    // Update the box of id. A box that left the leaf's fattened one grows the leaf and
+    // its ancestors to cover it; Rebalance re-inserts it later.
+    void Move(unsigned int id, const AABB& box) {
+        if (id >= leafOf.size() || leafOf[id] < 0) {
+            Insert(id, box);
+            return;
+        }
+        if (Fits(id, box))
+            return;
+        int leaf = leafOf[id];
+        nodes[leaf].box = AABB::Union(nodes[leaf].box, AABB(box.min - vec3(margin), box.max + vec3(margin)));
+        leafBoxes[id] = nodes[leaf].box;
+        Grow(leaf);
+        if (!nodes[leaf].grown) {
+            nodes[leaf].grown = true;
+            grownIds.push_back(id);
+        }
+    }
+
+    // Whether a Move of id to box would leave the tree as it is; reads only, so it may run
+    // on many threads between updates
+    bool Fits(unsigned int id, const AABB& box) const {
+        return id < leafOf.size() && leafOf[id] >= 0 && leafBoxes[id].Contains(box);
+    }
+
+    // Re-insert up to budget grown leaves, oldest first, at their current tight boxes:
+    // tightBox(id) returns the box a Move would get now
+    template <typename F>
+    void Rebalance(size_t budget, F tightBox) {
+        for (; budget > 0 && grownHead < grownIds.size(); grownHead++) {
+            unsigned int id = grownIds[grownHead];
+            if (leafOf[id] < 0 || !nodes[leafOf[id]].grown)
+                continue;   // Removed (and maybe added again) since
+            int leaf = leafOf[id];
+            AABB box = tightBox(id);
+            RemoveLeaf(leaf);
+            nodes[leaf].box = AABB(box.min - vec3(margin), box.max + vec3(margin));
+            nodes[leaf].grown = false;
+            leafBoxes[id] = nodes[leaf].box;
+            InsertLeaf(leaf);
+            budget--;
+        }
+        // Drop the handled ids once they are half the list, so it stays within the leaf count
+        if (grownHead * 2 >= grownIds.size()) {
+            grownIds.erase(grownIds.begin(), grownIds.begin() + grownHead);
+            grownHead = 0;
+        }
+    }
+
+    // Grown leaves waiting for Rebalance (some may be gone already)
+    size_t GrownCount() const {
+        return grownIds.size() - grownHead;
+    }
+
+    bool Contains(unsigned int id) const {
+        return id < leafOf.size() && leafOf[id] >= 0;
+    }
+
+    size_t Size() const {
+        return count;
+    }
+
+    // Walk leaves whose box the ray (unit dir) enters before maxT, nearest-box-first.
+    // f(id, maxT) tests the object and returns the distance to it, or maxT on a miss;
+    // the returned value becomes the new limit, so once something is hit only boxes in
+    // front of it are visited. Returns the final limit.
+    template <typename F>
+    float RayCast(vec3 origin, vec3 dir, float maxT, F f) const {
+        if (root < 0)
+            return maxT;
+        vec3 invDir = vec3(1.0f) / dir;
+        stack.clear();
+        float rootEnter = RayEnterAABB(origin, invDir, maxT, nodes[root].box);
+        if (rootEnter >= 0.0f)
+            stack.push_back(StackEntry{ root, rootEnter });
+        while (!stack.empty()) {
+            StackEntry entry = stack.back();
+            stack.pop_back();
+            if (entry.enter > maxT)
+                continue;   // A hit found since it was pushed is nearer
+            const Node& node = nodes[entry.node];
+            if (node.IsLeaf()) {
+                maxT = std::min(maxT, f((unsigned int)node.id, maxT));
+                continue;
+            }
+            float t0 = RayEnterAABB(origin, invDir, maxT, node.childBox[0]);
+            float t1 = RayEnterAABB(origin, invDir, maxT, node.childBox[1]);
+            // Push the farther child first so the nearer one is visited next
+            if (t0 >= 0.0f && t1 >= 0.0f) {
+                int nearer = t1 < t0 ? 1 : 0;
+                stack.push_back(StackEntry{ node.child[1 - nearer], nearer ? t0 : t1 });
+                stack.push_back(StackEntry{ node.child[nearer], nearer ? t1 : t0 });
+            }
+            else if (t0 >= 0.0f) {
+                stack.push_back(StackEntry{ node.child[0], t0 });
+            }
+            else if (t1 >= 0.0f) {
+                stack.push_back(StackEntry{ node.child[1], t1 });
+            }
+        }
+        return maxT;
+    }
+
+private:
+    int AllocateNode() {
+        int index;
+        if (!freeNodes.empty()) {
+            index = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else {
+            index = (int)nodes.size();
+            nodes.push_back(Node());
+        }
+        nodes[index].child[0] = -1;
+        nodes[index].child[1] = -1;
+        nodes[index].parent = -1;
+        nodes[index].id = -1;
+        nodes[index].grown = false;
+        return index;
+    }
+
+    void FreeNode(int index) {
+        freeNodes.push_back(index);
+    }
+
+    // Point parent's child link (and its box copy) at a new node
+    void SetChild(int parent, int side, int childNode) {
+        nodes[parent].child[side] = childNode;
+        nodes[parent].childBox[side] = nodes[childNode].box;
+        nodes[childNode].parent = parent;
+    }
+
+    int SideOf(int parent, int childNode) const {
+        return nodes[parent].child[0] == childNode ? 0 : 1;
+    }
+
+    void InsertLeaf(int leaf) {
+        if (root < 0) {
+            root = leaf;
+            nodes[leaf].parent = -1;
+            return;
+        }
+
+        // Descend towards the cheapest sibling: each step either stops here or goes down
+        // the child whose box grows least when it takes the new leaf
+        AABB leafBox = nodes[leaf].box;
+        int sibling = root;
+        while (!nodes[sibling].IsLeaf()) {
+            const Node& node = nodes[sibling];
+            float area = node.box.SurfaceArea();
+            float combined = AABB::Union(node.box, leafBox).SurfaceArea();
+            float costHere = 2.0f * combined;
+            float inherited = 2.0f * (combined - area);
+            float costLeft = ChildCost(node.child[0], leafBox) + inherited;
+            float costRight = ChildCost(node.child[1], leafBox) + inherited;
+            if (costHere < costLeft && costHere < costRight)
+                break;
+            sibling = costLeft < costRight ? node.child[0] : node.child[1];
+        }
+
+        int oldParent = nodes[sibling].parent;
+        int newParent = AllocateNode();
+        nodes[newParent].box = AABB::Union(leafBox, nodes[sibling].box);
+        if (oldParent < 0) {
+            root = newParent;
+            nodes[newParent].parent = -1;
+        }
+        else {
+            SetChild(oldParent, SideOf(oldParent, sibling), newParent);
+        }
+        SetChild(newParent, 0, sibling);
+        SetChild(newParent, 1, leaf);
+
+        Refit(oldParent);
+    }
+
+    float ChildCost(int child, const AABB& leafBox) const {
+        float combined = AABB::Union(nodes[child].box, leafBox).SurfaceArea();
+        if (nodes[child].IsLeaf())
+            return combined;
+        return combined - nodes[child].box.SurfaceArea();
+    }
+
+    void RemoveLeaf(int leaf) {
+        if (leaf == root) {
+            root = -1;
+            return;
+        }
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].child[1 - SideOf(parent, leaf)];
+        if (grandParent < 0) {
+            root = sibling;
+            nodes[sibling].parent = -1;
+        }
+        else {
+            SetChild(grandParent, SideOf(grandParent, parent), sibling);
+            Refit(grandParent);
+        }
+        FreeNode(parent);
+    }
+
+    // Widen the ancestors of a node whose box grew, up to the first that covers it
+    void Grow(int index) {
+        while (nodes[index].parent >= 0) {
+            int parent = nodes[index].parent;
+            nodes[parent].childBox[SideOf(parent, index)] = nodes[index].box;
+            if (nodes[parent].box.Contains(nodes[index].box))
+                return;
+            nodes[parent].box = AABB::Union(nodes[parent].box, nodes[index].box);
+            index = parent;
+        }
+    }
+
+    // Recompute boxes from index up to the root, keeping the parents' copies in step
+    void Refit(int index) {
+        while (index >= 0) {
+            Rotate(index);
+            Node& node = nodes[index];
+            node.box = AABB::Union(node.childBox[0], node.childBox[1]);
+            if (node.parent >= 0)
+                nodes[node.parent].childBox[SideOf(node.parent, index)] = node.box;
+            index = node.parent;
+        }
+    }
+
+    // Swap one child of inner node a with a grandchild on the other side when that
+    // shrinks the grandchild's parent the most; a's own box stays the same
+    void Rotate(int a) {
+        float bestArea = 0.0f;
+        int bestSide = -1, bestGrandchild = -1;
+        for (int side = 0; side < 2; side++) {
+            int other = nodes[a].child[1 - side];
+            if (nodes[other].IsLeaf())
+                continue;
+            float area = nodes[other].box.SurfaceArea();
+            for (int g = 0; g < 2; g++) {
+                // other would hold child `side` of a and its own child 1 - g
+                float shrink = area - AABB::Union(nodes[a].childBox[side], nodes[other].childBox[1 - g]).SurfaceArea();
+                if (shrink > bestArea) {
+                    bestArea = shrink;
+                    bestSide = side;
+                    bestGrandchild = g;
+                }
+            }
+        }
+        if (bestSide < 0)
+            return;
+        int other = nodes[a].child[1 - bestSide];
+        int moved = nodes[a].child[bestSide];
+        int grandchild = nodes[other].child[bestGrandchild];
+        SetChild(other, bestGrandchild, moved);
+        nodes[other].box = AABB::Union(nodes[other].childBox[0], nodes[other].childBox[1]);
+        SetChild(a, bestSide, grandchild);
+        nodes[a].childBox[1 - bestSide] = nodes[other].box;
+    }
+};
+
+#endif // !DYNAMICBVH_H
@@ -1,236 +1,478 @@
 ﻿#ifndef ENEMY_H 
 #define ENEMY_H
-#include <irrklang/irrKlang.h>
-using namespace irrklang;
 #include <glm/glm.hpp>
-#include <glm/gtc/random.hpp>
 using namespace glm;
 #include <cstdlib>
-#include <ctime>
+#include <iostream>
 #include <vector>
 using namespace std;
-#include "model.h"
-#include "shader.h"
 #include "camera.h"
-#include "texture.h"
-ISoundEngine* man= createIrrKlangDevice();
-int mancount = 0;
+#include "dynamicbvh.h"
+#include "enemybehaviors.h"
+#include "entitystore.h"
+#include "eventbus.h"
+#include "flowfield.h"
+#include "hitscan.h"
+#include "jobsystem.h"
+#include "rng.h"
+#include "simconfig.h"
+#include "simlod.h"
+#include "spatialgrid.h"
+#include "spawnzone.h"
+#include "staticbvh.h"
+#include "steering.h"
+#include "timerwheel.h"
+
+const char* const ENEMY_MODEL_PATH = "res/model/airen.obj";
+const float ENEMY_MODEL_SCALE = 2.0f;   // EnemyRenderer draws the model at this scale
+const size_t ENEMY_CHUNK = 2048;        // Enemies per parallel chunk
+const float ENEMY_SPAWN_HEIGHT = 13.5f;
+const size_t ENEMY_TREE_REBALANCE = 256;   // Grown hit volumes re-inserted per tick
+const float ENEMY_ARRIVE_DISTANCE = 1.0f;   // ENEMY_MOVE_TO stops this close to its target
+const int ENEMY_SPAWN_TRIES = 8;            // Free spawn points tried per enemy, walkers may stand on them
+
+// Enemy placement, movement, facing, hit tests and spawning. Enemies live in a shared
+// EntityStore that BallManager also reads for their shooters. They walk towards the
+// player along a FlowField around the room's walls, unless their behavior script
+// (EnemyOrders, enemybehaviors.h) says otherwise. GL-free; drawn by EnemyRenderer.
 class Enemy {
 private:
-    vec2 windowSize;
-    Model* enemy;
-    Shader* enemyShader;
-    Texture* diffuseMap;
-    GLuint maxNumber; // Current number of enemies on field
-    GLuint killCount; // Number of enemies killed
+    unsigned int maxNumber; // Current number of enemies on field
     vec3 basicPos;
-    vector<vec3> position;
-    vector<float> angles;
-    Camera* camera;
-    mat4 model, projection, view;
-    mat4 lightSpaceMatrix;
+    EntityStore* entities;
+    DynamicBVH enemyTree;   // Enemy hit volumes by entity slot, for shots
+    HitCapsule hitCapsule;  // Hit volume of one enemy, from its model
+    vector<HitscanRay> shots;       // Shots fired this tick, cut short where they hit
+    vector<HitscanHit> shotResults; // Scratch for ResolveShots
+    vector<unsigned char> treeUpdates;  // Scratch for UpdateMovement, per dense index
+    NeighbourGrid neighbours;   // Enemy positions at the start of UpdateMovement, or of a spawn
+    vector<NeighbourSums> steering; // Scratch for UpdateMovement, per grid entry
+    const Camera* camera;
+    JobSystem* jobs;        // Splits the per-enemy loops, may be NULL
+    const StaticBVH* world; // Walls shots stop at, may be NULL
+    EventBus* events;       // Kills and spawns go here, may be NULL
     
     // Added: Timed enemy spawning system
-    float spawnTimer;       // Spawn timer
+    TimerWheel<int> spawnTimer; // Next spawn
+    double clock;           // Seconds simulated, the spawn timer's time
+    bool spawnDue;          // Timer ran out while the field was full
     float spawnInterval;    // Spawn interval (seconds)
-    GLuint maxEnemyLimit;   // Maximum enemy count on field
+    float spawnIntervalScale;   // Spawn intervals times this (SpawnDirector)
+    unsigned int maxEnemyLimit;   // Maximum enemy count on field
+    unsigned int spawnBatch;      // Enemies added per spawn
+    Rng spawnRng;           // Spawn positions
+    SpawnZone spawnZone;    // Free spawn points, enemies kept spacing apart
+    vector<vec3> spawnPoints;   // Where each entity slot appeared...
+    vector<unsigned char> onSpawnPoint; // ...and whether it still blocks that point
+
+    FlowField navField;     // Way to the player
+    size_t navBudget;       // Flow field cells built per tick
+    float moveSpeed;
+    float stopDistance;     // Enemies this close to the player stop walking at it
+    float separation;       // Enemies steer to keep this far apart
+
+    bool behaviorsEnabled;  // Enemies run behavior scripts
+    BehaviorScheduler behaviors;
+    EnemyBehaviorContext behaviorContext;
+    vector<EntityId> shotRequests;  // Shots the scripts asked for in the last UpdateBehaviors
+
+    LodPolicy lod;          // Far enemies turn every few ticks
+    LodStats lodStats;      // Buckets of the last UpdateFacing
+    unsigned long long facingTick; // UpdateFacing calls so far, phase of the LOD buckets
 public:
-    Enemy(vec2 windowSize, Camera* camera, mat4 lightSpaceMat) : lightSpaceMatrix(lightSpaceMat){
-        this->windowSize = windowSize;
+    Enemy(const Camera* camera, EntityStore* entities, unsigned long long seed, const SimConfig& config = SimConfig())
+        : neighbours(ARENA_HALF_SIZE, 2.0f * config.enemySeparation, entities->Capacity()),
+        spawnRng(seed, RNG_STREAM_ENEMY_SPAWN),
+        spawnZone(SpawnZoneShape(config.enemySpawnRange, config.enemySafeZone, config.enemySpacing, ENEMY_SPAWN_HEIGHT), spawnRng),
+        navField(ARENA_HALF_SIZE, config.navCellSize), navBudget(config.navCellsPerTick),
+        moveSpeed(config.enemyMoveSpeed), stopDistance(config.enemyStopDistance), separation(config.enemySeparation),
+        behaviorsEnabled(config.enemyBehaviors), behaviors(config.enemyBehaviors ? entities->Capacity() : 0),
+        behaviorContext(&behaviors, entities, camera, seed),
+        lod(config), facingTick(0) {
         this->camera = camera;
+        this->entities = entities;
+        jobs = NULL;
+        world = NULL;
+        events = NULL;
         basicPos = vec3(0.0, 0.0, 0.0);
-        maxNumber = 6;
-        killCount = 0;
+        maxNumber = config.initialEnemies;
         
         // Initialize timed spawning system
-        spawnTimer = 0.0f;
-        spawnInterval = 2.0f;   // Spawn one enemy every 2 seconds
-        maxEnemyLimit = 20;     // Maximum 20 enemies on field
+        clock = 0.0;
+        spawnDue = false;
+        spawnInterval = config.enemySpawnInterval;  // 2 seconds by default
+        spawnIntervalScale = 1.0f;
+        spawnTimer.Schedule(TimerDue(spawnInterval), 0);
+        maxEnemyLimit = config.maxEnemies;          // 20 by default
+        spawnBatch = config.enemySpawnBatch;
+        spawnPoints.resize(entities->Capacity());
+        steering.reserve(entities->Capacity());
+        onSpawnPoint.assign(entities->Capacity(), 0);
         
         AddEnemy(maxNumber);
-        LoadModel();
-        LoadTexture();
-        LoadShader();
+        // Open floor until SetObstacles; enemies can walk from the first tick
+        navField.Retarget(camera->GetPosition());
+        navField.Update(NULL, NAV_UNLIMITED);
     }
 
     void Update(vec3 pos, vec3 dir, bool isShoot, float deltaTime) {
-        this->view = camera->GetViewMatrix();
-        this->projection = perspective(radians(camera->GetZoom()), windowSize.x / windowSize.y, 0.1f, 500.0f);
+        UpdateNavigation();
+        UpdateFacing();
+        UpdateShotsAndSpawning(pos, dir, isShoot, deltaTime);
+    }
+
+    // Split the per-enemy loops over these workers (NULL: run them inline)
+    void SetJobSystem(JobSystem* jobs) {
+        this->jobs = jobs;
+    }
+
+    // Report kills and spawns here (NULL: nowhere)
+    void SetEventBus(EventBus* events) {
+        this->events = events;
+    }
+
+    // Turn enemies towards the player; only writes angles and LOD buckets. Far enemies
+    // turn every few ticks (LodPolicy); the facing is worked out afresh each time, so
+    // there is no skipped time to catch up on.
+    void UpdateFacing() {
+        Span<const vec3> position = entities->Positions();
+        Span<float> angles = entities->Angles();
+        Span<unsigned char> buckets = entities->LodBuckets();
+        vec3 playerPos = camera->GetPosition();
+        vec3 front = camera->GetFront();
+        facingTick++;
+        mutex statsLock;
+        lodStats.Clear();
 
         // Update orientation
-        for (size_t i = 0; i < position.size(); ++i) {
-            vec3 toPlayer = normalize(camera->GetPosition() - position[i]);
-            angles[i] = atan2(toPlayer.x, toPlayer.z);
-        }
+        ParallelFor(jobs, position.size, ENEMY_CHUNK, [&](size_t begin, size_t end) {
+            LodStats stats;
+            for (size_t i = begin; i < end; ++i) {
+                stats.entities[buckets[i]]++;
+                if (!LodPolicy::IsDue(buckets[i], facingTick, entities->IdAt(i).slot))
+                    continue;
+                vec3 toPlayer = normalize(playerPos - position[i]);
+                angles[i] = atan2(toPlayer.x, toPlayer.z);
+                buckets[i] = (unsigned char)lod.Bucket(position[i], playerPos, front);
+                stats.updated++;
+            }
+            lock_guard<mutex> guard(statsLock);
+            lodStats.Add(stats);
+        });
+    }
 
-        // Handle player shooting
-        if (isShoot) {
-            for (size_t i = 0; i < position.size(); ++i) {
-                vec3 des = (pos.z - position[i].z) / (-dir.z) * dir + pos;
-                float threshold=5;
-                if (abs(position[i].x - des.x)<=threshold&&abs(position[i].y - des.y) <=threshold) {
-                    // Hit, remove enemy
-                    position.erase(position.begin() + i);
-                    angles.erase(angles.begin() + i);
-                    killCount++;
-                    if(mancount%2==0)
-                    man->play2D("res/audio/man0.mp3", GL_FALSE);
-                    else
-                    man->play2D("res/audio/man1.mp3", GL_FALSE);
-                    mancount++;
-                    cout << "Enemy killed! Current kill count: " << killCount << endl;
-                    break; // Only kill one at a time
-                }
+    // Follow the player with the flow field: a new build starts when the player changed
+    // cell, and each call builds at most the budget. Only touches the field, so it runs
+    // beside the other systems.
+    void UpdateNavigation() {
+        navField.Retarget(camera->GetPosition());
+        navField.Update(jobs, navBudget);
+    }
+
+    // Block the flow field where the room's triangles (three vertices each) stand, and
+    // build the first field around them at once
+    void SetObstacles(const vector<vec3>& triangles) {
+        navField.SetObstacles(triangles);
+        navField.Retarget(camera->GetPosition());
+        navField.Update(jobs, NAV_UNLIMITED);
+    }
+
+    // Spawn up to maxEnemies, at intervalScale times the configured interval from the
+    // next spawn on. Enemies already above a lowered cap stay until shot.
+    void SetSpawnLimits(unsigned int maxEnemies, float intervalScale) {
+        maxEnemyLimit = maxEnemies;
+        spawnIntervalScale = intervalScale;
+    }
+
+    // Resume the behavior scripts that are due (BehaviorScheduler), on the workers. Shots
+    // they ask for wait in GetShotRequests until the next call.
+    void UpdateBehaviors(float deltaTime) {
+        shotRequests.clear();
+        if (!behaviorsEnabled)
+            return;
+        Span<EnemyOrders> orders = entities->Orders();
+        behaviors.Update(jobs, deltaTime, [&](EntityId id) {
+            EnemyOrders& o = orders[entities->IndexOf(id)];
+            for (; o.shots > 0; o.shots--) {
+                shotRequests.push_back(id);
             }
-        }
-        
-        // Timed spawning of new enemies
-        UpdateEnemySpawning(deltaTime);
+        });
     }
 
-    void Render(Shader* shaderToUse, GLuint depthMapID = 0) { // 参数名和类型与Place类中类似
-        if (!enemy) return; // 检查模型是否已加载
+    const vector<EntityId>& GetShotRequests() const {
+        return shotRequests;
+    }
 
-        const auto& enemySubMeshes = enemy->GetSubMeshes();
-        if (enemySubMeshes.empty()) return; // 如果模型没有子网格，则不渲染
+    // The player's shots of the last UpdateShots, each ending at the wall or enemy it hit
+    const vector<HitscanRay>& GetShots() const {
+        return shots;
+    }
 
-        const auto& firstSubMesh = enemySubMeshes[0]; // 假设敌人模型是单个子网格，或只渲染第一个
+    const BehaviorScheduler& GetBehaviors() const {
+        return behaviors;
+    }
 
-        for (size_t i = 0; i < position.size(); i++) {
-            model = glm::mat4(1.0); // 明确 glm::
-            model = glm::translate(model, position[i]); // 明确 glm::
-            model = glm::rotate(model, angles[i], glm::vec3(0, 1, 0)); // 明确 glm::
-            model = glm::scale(model, glm::vec3(2)); // 明确 glm::
+    // Stop the player's shots at these walls (NULL: shots reach HITSCAN_RANGE)
+    void SetWorld(const StaticBVH* world) {
+        this->world = world;
+    }
 
-            Shader* currentShader = shaderToUse;
-            if (currentShader == NULL) {
-                currentShader = enemyShader;
-                currentShader->Bind();
-                currentShader->SetMat4("projection", projection);
-                currentShader->SetMat4("view", view);
-                currentShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
-                // 如果 enemyShader 需要其他 uniforms (如 viewPos, lightPos)，也应在此处设置
-                currentShader->SetVec3("viewPos", camera->GetPosition());
-                // lightPos 等已在 LoadShader 中为 enemyShader 设置过，如果是静态的就不用每帧传
-            }
-            else {
-                currentShader->Bind();
-            }
+    const FlowField& GetFlowField() const {
+        return navField;
+    }
 
-            currentShader->SetMat4("model", model);
+    // Enemies per LOD bucket and how many turned in the last UpdateFacing
+    const LodStats& GetLodStats() const {
+        return lodStats;
+    }
 
-            // 纹理和深度图绑定
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, diffuseMap->GetId()); // 敌人自己的漫反射贴图
+    // Kill what the player shot, walk the rest and spawn new enemies; adds, moves and
+    // removes entities. Shots hit enemies where the player saw them, before they move.
+    void UpdateShotsAndSpawning(vec3 pos, vec3 dir, bool isShoot, float deltaTime) {
+        UpdateShots(pos, dir, isShoot);
+        UpdateMovement(deltaTime);
+        
+        // Timed spawning of new enemies
+        UpdateEnemySpawning(deltaTime);
+    }
+
+    void UpdateShots(vec3 pos, vec3 dir, bool isShoot) {
+        shots.clear();
+        // Handle player shooting: the nearest enemy along the aim ray before a wall is hit
+        if (isShoot && length(dir) > 0.0f) {
+            behaviors.Signal(BEHAVIOR_EVENT_PLAYER_FIRED);
+            HitscanRay ray(pos, normalize(dir));
+            float wall = world ? world->Raycast(ray.origin, ray.dir, ray.maxDistance) : -1.0f;
+            if (wall >= 0.0f)
+                ray.maxDistance = wall;
+            shots.push_back(ray);
+        }
+        ResolveShots();
+    }
+
+    // Walk every enemy the way its orders say, by default the flow field's direction (none
+    // within the stop distance), plus crowd steering, separation from and cohesion with
+    // the enemies around, summed in vector lanes from a grid of this tick's starting
+    // positions (SumNeighbours), and clearance from blocked floor. Velocity turns towards
+    // the result at STEER_RESPONSE. Each enemy only writes itself, so the chunks run on
+    // the workers in any order with the same result.
+    void UpdateMovement(float deltaTime) {
+        Span<vec3> position = entities->Positions();
+        Span<vec3> velocity = entities->Velocities();
+        Span<const EnemyOrders> orders = entities->Orders();
+        vec3 playerPos = camera->GetPosition();
+        float stopSq = stopDistance * stopDistance;
+        float range = 2.0f * separation;
+        float clearance = navField.GetCellSize();
+        float response = std::min(1.0f, STEER_RESPONSE * deltaTime);
+        if (deltaTime <= 0.0f)
+            return;
+        neighbours.Build(position, jobs);
+        steering.resize(position.size);
+        ParallelFor(jobs, position.size, STEER_CHUNK, [&](size_t begin, size_t end) {
+            SumNeighbours(neighbours, begin, end, separation, steering.data());
+        });
+        treeUpdates.resize(position.size);
+        ParallelFor(jobs, position.size, ENEMY_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                treeUpdates[i] = 0;
+                vec3 pos = position[i];
+                const NeighbourSums& sums = steering[neighbours.EntryOf(i)];
+                vec2 desired(0.0f);
+                float dx = playerPos.x - pos.x, dz = playerPos.z - pos.z;
+                const EnemyOrders& o = orders[i];
+                if (o.move == ENEMY_MOVE_CHASE) {
+                    if (dx * dx + dz * dz > stopSq)
+                        desired = navField.Sample(pos);
+                }
+                else if (o.move == ENEMY_MOVE_TO) {
+                    vec2 to(o.target.x - pos.x, o.target.z - pos.z);
+                    float distance = length(to);
+                    if (distance > ENEMY_ARRIVE_DISTANCE)
+                        desired = to / distance;
+                }
+                else if (o.move == ENEMY_MOVE_STRAFE) {
+                    float distance = sqrt(dx * dx + dz * dz);
+                    if (distance > 0.0f)
+                        desired = vec2(-dz, dx) / distance * o.strafe;
+                }
+                desired += STEER_SEPARATION_WEIGHT * vec2(sums.separationX, sums.separationZ);
+                if (sums.count > 0.0f)
+                    desired += STEER_COHESION_WEIGHT / range * (vec2(sums.centerX, sums.centerZ) / sums.count - vec2(pos.x, pos.z));
+                desired += STEER_AVOID_WEIGHT * navField.Clearance(pos, clearance);
+                float desiredLength = length(desired);
+                if (desiredLength > 1.0f)
+                    desired /= desiredLength;
+                vec3 v = velocity[i] + (vec3(desired.x, 0.0f, desired.y) * moveSpeed - velocity[i]) * response;
 
-            if (currentShader == enemyShader && depthMapID != 0) { // 如果使用 enemyShader 且有深度图
-                glActiveTexture(GL_TEXTURE1); // 假设 enemyShader 的 shadowMap 在纹理单元1
-                glBindTexture(GL_TEXTURE_2D, depthMapID);
-                currentShader->SetInt("shadowMap_tex", 1); // 假设你的 enemyShader 中阴影贴图 uniform 名为 material.shadowMap
-                // 或者根据实际 uniform 名进行设置，如 "shadowMap"
-                // 你的 LoadShader 中设置的是 "material.diffuse" 和 "material.specular"
-                // 你需要为 enemyShader 添加 shadowMap uniform
+                // Never step from open floor onto blocked floor; slide along it instead
+                vec3 next = pos + v * deltaTime;
+                if (navField.IsBlocked(next) && !navField.IsBlocked(pos)) {
+                    if (!navField.IsBlocked(vec3(next.x, pos.y, pos.z)))
+                        v.z = 0.0f;
+                    else if (!navField.IsBlocked(vec3(pos.x, pos.y, next.z)))
+                        v.x = 0.0f;
+                    else
+                        v = vec3(0.0f);
+                    next = pos + v * deltaTime;
+                }
+                velocity[i] = v;
+                if (next == pos)
+                    continue;
+                position[i] = next;
+                unsigned int slot = entities->IdAt(i).slot;
+                treeUpdates[i] = onSpawnPoint[slot] || !enemyTree.Fits(slot, hitCapsule.Bounds(next));
             }
+        });
 
+        // Hit volumes follow the enemies that left theirs, and a few grown ones are
+        // re-inserted tightly
+        for (size_t i = 0; i < position.size; i++) {
+            if (!treeUpdates[i])
+                continue;
+            unsigned int slot = entities->IdAt(i).slot;
+            LeaveSpawnPoint(slot);
+            enemyTree.Move(slot, hitCapsule.Bounds(position[i]));
+        }
+        enemyTree.Rebalance(ENEMY_TREE_REBALANCE, [&](unsigned int slot) {
+            return hitCapsule.Bounds(position[entities->IndexOfSlot(slot)]);
+        });
+    }
 
-            // 修改开始: 使用子网格数据进行渲染
-            glBindVertexArray(firstSubMesh.VAO);
-            glDrawElements(GL_TRIANGLES, firstSubMesh.indexCount, GL_UNSIGNED_INT, 0);
-            // 修改结束
+    // 新增：定时生成敌人的方法
+    void UpdateEnemySpawning(float deltaTime) {
+        clock += deltaTime;
+        spawnTimer.Advance(TimerNow(clock), [&](int, unsigned long long) { spawnDue = true; });
+        
+        // A spawn that came due on a full field waits for a kill
+        if (spawnDue && entities->Size() < maxEnemyLimit) {
+            neighbours.Build(entities->Positions(), jobs);
+            AddEnemy(std::min(spawnBatch, maxEnemyLimit - (unsigned int)entities->Size()));
+            spawnDue = false;
+            spawnTimer.Schedule(TimerDue(clock + spawnInterval * spawnIntervalScale), 0);
+        }
+    }
 
-            // 不要在循环内部解绑 VAO 和 Shader，除非每个迭代都用不同的
+    // Nearest enemy hit by each ray, one result per ray. Ids are entity slots.
+    void CastRays(const vector<HitscanRay>& rays, vector<HitscanHit>& outHits) const {
+        Span<const vec3> position = entities->Positions();
+        Span<const float> angles = entities->Angles();
+        outHits.assign(rays.size(), HitscanHit());
+        for (size_t r = 0; r < rays.size(); r++) {
+            const HitscanRay& ray = rays[r];
+            HitscanHit& hit = outHits[r];
+            enemyTree.RayCast(ray.origin, ray.dir, ray.maxDistance, [&](unsigned int slot, float maxT) {
+                size_t i = entities->IndexOfSlot(slot);
+                vec3 a, b;
+                hitCapsule.Segment(position[i], angles[i], a, b);
+                float t = IntersectRayCapsule(ray.origin, ray.dir, a, b, hitCapsule.radius);
+                if (t < 0.0f || t >= maxT)
+                    return maxT;
+                hit.id = (int)slot;
+                hit.distance = t;
+                return t;
+            });
         }
+    }
 
-        // 在所有敌人渲染完毕后解绑
-        if (shaderToUse == NULL && enemyShader) {
-            enemyShader->Unbind();
-        } else if (shaderToUse != NULL) {
-            // shaderToUse->Unbind(); // 通常由调用RenderDepth的地方统一处理其shader解绑
+    // Use a new hit volume for every enemy (e.g. fitted to the loaded model's vertices)
+    void SetHitCapsule(const HitCapsule& capsule) {
+        hitCapsule = capsule;
+        Span<const vec3> position = entities->Positions();
+        for (size_t i = 0; i < position.size; i++) {
+            enemyTree.Insert(entities->IdAt(i).slot, hitCapsule.Bounds(position[i]));
         }
-        glBindVertexArray(0); // 最后解绑VAO
     }
 
-    GLuint GetKillCount() {
-        return killCount;
+    const HitCapsule& GetHitCapsule() const {
+        return hitCapsule;
     }
-    
+
     // Get current enemy count
     size_t GetEnemyCount() const {
-        return position.size();
+        return entities->Size();
     }
     
     // Get maximum enemy limit
-    GLuint GetMaxEnemyLimit() const {
+    unsigned int GetMaxEnemyLimit() const {
         return maxEnemyLimit;
     }
     
-    // Added: Get all enemy positions for bullet system
-    vector<vec3> GetEnemyPositions() const {
-        return position;
+    Span<const vec3> GetPositions() const {
+        return entities->Positions();
+    }
+
+    Span<const float> GetAngles() const {
+        return entities->Angles();
+    }
+
+    EntityId GetIdAt(size_t i) const {
+        return entities->IdAt(i);
     }
 
 private:
-    void LoadModel() {
-        enemy = new Model("res/model/airen.obj");
-
-    }
-    void LoadTexture() {
-        diffuseMap = new Texture("res/texture/airen.jpg");
-
-    }
-    void LoadShader()
-    {
-        enemyShader = new Shader("res/shader/enemy.vert", "res/shader/enemy.frag");
-        enemyShader->Bind();
-        enemyShader->SetInt("material.diffuse", 0);
-        enemyShader->SetInt("material.specular", 1);
-        enemyShader->SetFloat("material.shininess", 64.0);
-        enemyShader->SetVec3("light.position", vec3(0.0, 400.0, 150.0));
-        enemyShader->SetVec3("light.ambient", vec3(0.2));
-        enemyShader->SetVec3("light.diffuse", vec3(0.65));
-        enemyShader->SetVec3("light.specular", vec3(1.0));
-        enemyShader->SetVec3("viewPos", camera->GetPosition());
-        enemyShader->SetInt("shadowMap_tex", 1); // 告诉着色器 shadowMap_tex 在单元1
-        enemyShader->SetMat4("lightSpaceMatrix", this->lightSpaceMatrix); // <<< 新增：传递 lightSpaceMatrix
-
-        enemyShader->Unbind();
-    }
-    void AddEnemy(GLuint count) {
-        for (GLuint i = 0; i < count; i++) {
-            int tryCount = 0;
-            while (tryCount < 200) { // ֹѭ
-                float x = (rand() % 80) - 40;
-                float z = (rand() % 80) - 40;
-                if (abs(x) <= 20 || abs(z) <= 20)
-                    continue;
-                float y = 13.5;
-                vec3 pos = vec3(x,y,z);
-                if (CheckPosition(pos)) {
-                    position.push_back(pos);
-                    angles.push_back(0.0f);
-                    break;
-                }
-                tryCount++;
+    // Add up to count enemies at free spawn points; stops early when the zone is full or
+    // the points tried are taken. The zone only knows the enemies still on their spawn
+    // points, so the points are also checked against neighbours, built where every enemy
+    // stands before the spawn.
+    void AddEnemy(unsigned int count) {
+        float spacing = spawnZone.GetShape().spacing;
+        for (unsigned int i = 0; i < count; i++) {
+            vec3 pos;
+            bool clear = false;
+            for (int t = 0; t < ENEMY_SPAWN_TRIES && !clear; t++) {
+                if (!spawnZone.Pick(spawnRng, pos))
+                    return;
+                clear = !neighbours.AnyWithin(pos.x, pos.z, spacing);
             }
+            if (!clear)
+                return;
+            EntityId id = entities->Add(pos);
+            if (!id.IsValid())
+                return;
+            spawnZone.Occupy(pos);
+            spawnPoints[id.slot] = pos;
+            onSpawnPoint[id.slot] = 1;
+            enemyTree.Insert(id.slot, hitCapsule.Bounds(pos));
+            if (behaviorsEnabled)
+                behaviors.Start(id, StartEnemyBehavior(behaviorContext, id));
+            if (events)
+                events->Push(GameEvent(GAME_EVENT_ENEMY_SPAWNED, pos, 0.0f, (unsigned int)entities->Size()));
         }
     }
-    bool CheckPosition(vec3 pos) {
-        for (size_t i = 0; i < position.size(); i++) {
-            float away = pow(position[i].x - pos.x, 2) + pow(position[i].y - pos.y, 2);
-            if (away < 100)
-                return false;
-        }
-        return true;
+    void RemoveEnemyAt(size_t i) {
+        unsigned int slot = entities->IdAt(i).slot;
+        if (behaviorsEnabled)
+            behaviors.Stop(entities->IdAt(i));
+        LeaveSpawnPoint(slot);
+        enemyTree.Remove(slot);
+        entities->RemoveAt(i);
     }
-    
-    // 新增：定时生成敌人的方法
-    void UpdateEnemySpawning(float deltaTime) {
-        spawnTimer += deltaTime;
-        
-        if (spawnTimer >= spawnInterval && position.size() < maxEnemyLimit) {
-            AddEnemy(1);
-            spawnTimer = 0.0f;
-            cout << "New enemy spawned! Current enemy count: " << position.size() << endl;
+
+    // The slot's enemy no longer blocks its spawn point for new ones
+    void LeaveSpawnPoint(unsigned int slot) {
+        if (!onSpawnPoint[slot])
+            return;
+        spawnZone.Release(spawnPoints[slot]);
+        onSpawnPoint[slot] = 0;
+    }
+
+    // Cast this tick's shots as one batch and kill what they hit; the shots end there
+    void ResolveShots() {
+        if (shots.empty())
+            return;
+        CastRays(shots, shotResults);
+        for (size_t r = 0; r < shotResults.size(); r++) {
+            if (shotResults[r].IsHit())
+                shots[r].maxDistance = shotResults[r].distance;
+            // Two shots may hit the same enemy, the second finds it gone
+            if (!shotResults[r].IsHit() || !enemyTree.Contains(shotResults[r].id))
+                continue;
+            size_t i = entities->IndexOfSlot(shotResults[r].id);
+            if (events)
+                events->Push(GameEvent(GAME_EVENT_ENEMY_KILLED, entities->Positions()[i]));
+            RemoveEnemyAt(i);
+            behaviors.Signal(BEHAVIOR_EVENT_ENEMY_KILLED);
         }
     }
 };
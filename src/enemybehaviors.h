@@ -0,0 +1,124 @@
+#ifndef ENEMYBEHAVIORS_H
+#define ENEMYBEHAVIORS_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include "behavior.h"
+#include "camera.h"
+#include "entitystore.h"
+#include "rng.h"
+
+const float PATROL_RADIUS = 15.0f;          // Patrol legs end this far from where the enemy appeared
+const double PATROL_LEG_SECONDS = 4.0;      // Walking time per leg
+const float PATROL_SIGHT = 40.0f;           // The patrol ends with the player this close...
+const float PATROL_HEARING = 80.0f;         // ...or firing this close
+const float STRAFE_RANGE = 50.0f;           // Enemies this close dodge the player's fire...
+const double STRAFE_CHECK_SECONDS = 1.0;    // ...farther ones look again this often
+const double STRAFE_MIN_SECONDS = 0.5;      // Dodges last min + [0, spread)
+const double STRAFE_SPREAD_SECONDS = 1.0;
+const int BURST_SHOTS = 3;
+const double BURST_GAP_SECONDS = 0.15;      // Between the shots of a burst
+const double BURST_PAUSE_SECONDS = 3.0;     // Between bursts: pause + [0, spread), cut short by a kill
+const double BURST_PAUSE_SPREAD = 2.0;
+
+// What enemy behavior scripts see of the game. Scripts run on the workers, so they only
+// read the player and their own enemy and only write their own EnemyOrders. Look the
+// enemy up again after every co_await: other enemies come and go meanwhile.
+class EnemyBehaviorContext {
+private:
+    BehaviorScheduler* scheduler;
+    EntityStore* entities;
+    const Camera* camera;
+    unsigned long long seed;
+
+public:
+    EnemyBehaviorContext(BehaviorScheduler* scheduler, EntityStore* entities, const Camera* camera, unsigned long long seed)
+        : scheduler(scheduler), entities(entities), camera(camera), seed(seed) {}
+
+    BehaviorFramePool& GetFramePool() { return scheduler->GetFramePool(); }
+
+    vec3 Position(EntityId self) const { return entities->Positions()[entities->IndexOf(self)]; }
+    EnemyOrders& Orders(EntityId self) { return entities->Orders()[entities->IndexOf(self)]; }
+    vec3 PlayerPosition() const { return camera->GetPosition(); }
+
+    // Distance to the player on the floor
+    float PlayerDistance(EntityId self) const {
+        vec3 d = PlayerPosition() - Position(self);
+        return length(vec2(d.x, d.z));
+    }
+
+    // The enemy's n-th draw, uniform in [0, 1); the same on every run and thread count
+    float Random(EntityId self, unsigned int n) const {
+        unsigned long long key = ((unsigned long long)self.generation << 32) | self.slot;
+        return HashRandomBelow(seed, RNG_STREAM_ENEMY_BEHAVIOR, key, n, 65536) / 65536.0f;
+    }
+};
+
+// Walk between points around where the enemy appeared until the player comes close or
+// fires nearby, then chase like the others
+inline Behavior PatrolBehavior(EnemyBehaviorContext& ctx, EntityId self) {
+    vec3 home = ctx.Position(self);
+    unsigned int draws = 0;
+    for (;;) {
+        float angle = ctx.Random(self, draws++) * 2.0f * glm::pi<float>();
+        EnemyOrders& orders = ctx.Orders(self);
+        orders.move = ENEMY_MOVE_TO;
+        orders.target = home + vec3(cos(angle), 0.0f, sin(angle)) * PATROL_RADIUS;
+        // Out of earshot the player's shots need not wake it
+        bool heard = false;
+        if (ctx.PlayerDistance(self) < PATROL_HEARING)
+            heard = co_await WaitEvent(BEHAVIOR_EVENT_PLAYER_FIRED, PATROL_LEG_SECONDS);
+        else
+            co_await WaitSeconds(PATROL_LEG_SECONDS);
+        if (heard || ctx.PlayerDistance(self) < PATROL_SIGHT)
+            break;
+    }
+    ctx.Orders(self).move = ENEMY_MOVE_CHASE;
+}
+
+// Chase, and sidestep for a moment whenever the player fires from close by
+inline Behavior StrafeBehavior(EnemyBehaviorContext& ctx, EntityId self) {
+    unsigned int draws = 0;
+    for (;;) {
+        // Only the close ones listen for shots; the rest would wake on every one for nothing
+        if (ctx.PlayerDistance(self) > STRAFE_RANGE) {
+            co_await WaitSeconds(STRAFE_CHECK_SECONDS);
+            continue;
+        }
+        if (!co_await WaitEvent(BEHAVIOR_EVENT_PLAYER_FIRED, STRAFE_CHECK_SECONDS))
+            continue;
+        EnemyOrders& orders = ctx.Orders(self);
+        orders.move = ENEMY_MOVE_STRAFE;
+        orders.strafe = ctx.Random(self, draws++) < 0.5f ? -1.0f : 1.0f;
+        co_await WaitSeconds(STRAFE_MIN_SECONDS + STRAFE_SPREAD_SECONDS * ctx.Random(self, draws++));
+        ctx.Orders(self).move = ENEMY_MOVE_CHASE;
+    }
+}
+
+// Chase and fire in bursts instead of single shots; the player killing any enemy sets off
+// the next burst early
+inline Behavior BurstFireBehavior(EnemyBehaviorContext& ctx, EntityId self) {
+    unsigned int draws = 0;
+    ctx.Orders(self).scriptedFire = 1;
+    for (;;) {
+        co_await WaitEvent(BEHAVIOR_EVENT_ENEMY_KILLED, BURST_PAUSE_SECONDS + BURST_PAUSE_SPREAD * ctx.Random(self, draws++));
+        for (int shot = 0; shot < BURST_SHOTS; shot++) {
+            ctx.Orders(self).shots++;
+            co_await WaitSeconds(BURST_GAP_SECONDS);
+        }
+    }
+}
+
+// Script for a new enemy: patrol, strafe or burst fire, drawn from its id
+inline Behavior StartEnemyBehavior(EnemyBehaviorContext& ctx, EntityId self) {
+    switch ((int)(ctx.Random(self, 0xFFFFFFFFu) * 3.0f)) {
+    case 0:
+        return PatrolBehavior(ctx, self);
+    case 1:
+        return StrafeBehavior(ctx, self);
+    default:
+        return BurstFireBehavior(ctx, self);
+    }
+}
+
+#endif // !ENEMYBEHAVIORS_H
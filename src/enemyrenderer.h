@@ -0,0 +1,193 @@
+#ifndef ENEMYRENDERER_H
+#define ENEMYRENDERER_H
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+using namespace glm;
+#include <vector>
+using namespace std;
+#include "model.h"
+#include "shader.h"
+#include "camera.h"
+#include "texture.h"
+#include "enemy.h"
+
+// Draws the enemies owned by an Enemy system. Holds the enemy model, texture and shader.
+class EnemyRenderer {
+private:
+    vec2 windowSize;
+    Model* enemy;
+    Shader* enemyShader;
+    Texture* diffuseMap;
+    const Enemy* enemies;
+    const Camera* camera;
+    mat4 model, projection, view;
+    mat4 lightSpaceMatrix;
+    // Facing and position at the previous tick by entity slot, drawn blended towards the
+    // current ones
+    vector<float> previousAngles;
+    vector<vec3> previousPositions;
+    vector<EntityId> previousIds;
+    float alpha;
+public:
+    EnemyRenderer(vec2 windowSize, const Camera* camera, mat4 lightSpaceMat, const Enemy* enemies) : lightSpaceMatrix(lightSpaceMat), alpha(1.0f) {
+        this->windowSize = windowSize;
+        this->camera = camera;
+        this->enemies = enemies;
+
+        LoadModel();
+        LoadTexture();
+        LoadShader();
+    }
+
+    void Update() {
+        this->view = camera->GetViewMatrix();
+        this->projection = perspective(radians(camera->GetZoom()), windowSize.x / windowSize.y, 0.1f, 500.0f);
+    }
+
+    // Remember the current facing and positions; call right before each simulation tick
+    void SaveState() {
+        Span<const float> angles = enemies->GetAngles();
+        Span<const vec3> position = enemies->GetPositions();
+        for (size_t i = 0; i < angles.size; i++) {
+            EntityId id = enemies->GetIdAt(i);
+            if (id.slot >= previousAngles.size()) {
+                previousAngles.resize(id.slot + 1);
+                previousPositions.resize(id.slot + 1);
+                previousIds.resize(id.slot + 1);
+            }
+            previousAngles[id.slot] = angles[i];
+            previousPositions[id.slot] = position[i];
+            previousIds[id.slot] = id;
+        }
+    }
+
+    // Draw at this fraction of the way from the saved tick to the current one
+    void SetInterpolation(float alpha) {
+        this->alpha = alpha;
+    }
+
+    void Render(Shader* shaderToUse, GLuint depthMapID = 0) { // 参数名和类型与Place类中类似
+        if (!enemy) return; // 检查模型是否已加载
+
+        const auto& enemySubMeshes = enemy->GetSubMeshes();
+        if (enemySubMeshes.empty()) return; // 如果模型没有子网格，则不渲染
+
+        const auto& firstSubMesh = enemySubMeshes[0]; // 假设敌人模型是单个子网格，或只渲染第一个
+
+        Span<const vec3> position = enemies->GetPositions();
+        Span<const float> angles = enemies->GetAngles();
+        for (size_t i = 0; i < position.size; i++) {
+            model = glm::mat4(1.0); // 明确 glm::
+            model = glm::translate(model, InterpolatedPosition(i, position[i])); // 明确 glm::
+            model = glm::rotate(model, InterpolatedAngle(i, angles[i]), glm::vec3(0, 1, 0)); // 明确 glm::
+            model = glm::scale(model, glm::vec3(ENEMY_MODEL_SCALE)); // 明确 glm::
+
+            Shader* currentShader = shaderToUse;
+            if (currentShader == NULL) {
+                currentShader = enemyShader;
+                currentShader->Bind();
+                currentShader->SetMat4("projection", projection);
+                currentShader->SetMat4("view", view);
+                currentShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+                // 如果 enemyShader 需要其他 uniforms (如 viewPos, lightPos)，也应在此处设置
+                currentShader->SetVec3("viewPos", camera->GetPosition());
+                // lightPos 等已在 LoadShader 中为 enemyShader 设置过，如果是静态的就不用每帧传
+            }
+            else {
+                currentShader->Bind();
+            }
+
+            currentShader->SetMat4("model", model);
+
+            // 纹理和深度图绑定
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, diffuseMap->GetId()); // 敌人自己的漫反射贴图
+
+            if (currentShader == enemyShader && depthMapID != 0) { // 如果使用 enemyShader 且有深度图
+                glActiveTexture(GL_TEXTURE1); // 假设 enemyShader 的 shadowMap 在纹理单元1
+                glBindTexture(GL_TEXTURE_2D, depthMapID);
+                currentShader->SetInt("shadowMap_tex", 1); // 假设你的 enemyShader 中阴影贴图 uniform 名为 material.shadowMap
+                // 或者根据实际 uniform 名进行设置，如 "shadowMap"
+                // 你的 LoadShader 中设置的是 "material.diffuse" 和 "material.specular"
+                // 你需要为 enemyShader 添加 shadowMap uniform
+            }
+
+
+            // 修改开始: 使用子网格数据进行渲染
+            glBindVertexArray(firstSubMesh.VAO);
+            glDrawElements(GL_TRIANGLES, firstSubMesh.indexCount, GL_UNSIGNED_INT, 0);
+            // 修改结束
+
+            // 不要在循环内部解绑 VAO 和 Shader，除非每个迭代都用不同的
+        }
+
+        // 在所有敌人渲染完毕后解绑
+        if (shaderToUse == NULL && enemyShader) {
+            enemyShader->Unbind();
+        } else if (shaderToUse != NULL) {
+            // shaderToUse->Unbind(); // 通常由调用RenderDepth的地方统一处理其shader解绑
+        }
+        glBindVertexArray(0); // 最后解绑VAO
+    }
+
+    // Hit volume fitted to the loaded model's vertices
+    HitCapsule GetHitCapsule() const {
+        vector<vec3> vertices;
+        for (const auto& subMesh : enemy->GetSubMeshes()) {
+            vertices.insert(vertices.end(), subMesh.vertices.begin(), subMesh.vertices.end());
+        }
+        return ComputeHitCapsule(vertices, ENEMY_MODEL_SCALE);
+    }
+
+private:
+    // Enemies spawned since the saved tick are drawn as they are
+    bool IsSaved(size_t i) const {
+        EntityId id = enemies->GetIdAt(i);
+        return id.slot < previousIds.size() && previousIds[id.slot].slot == id.slot
+            && previousIds[id.slot].generation == id.generation;
+    }
+
+    float InterpolatedAngle(size_t i, float angle) const {
+        EntityId id = enemies->GetIdAt(i);
+        if (alpha >= 1.0f || !IsSaved(i))
+            return angle;
+        float turn = angle - previousAngles[id.slot];
+        // Shorter way round
+        if (turn > pi<float>()) turn -= two_pi<float>();
+        if (turn < -pi<float>()) turn += two_pi<float>();
+        return previousAngles[id.slot] + turn * alpha;
+    }
+
+    vec3 InterpolatedPosition(size_t i, vec3 pos) const {
+        if (alpha >= 1.0f || !IsSaved(i))
+            return pos;
+        return mix(previousPositions[enemies->GetIdAt(i).slot], pos, alpha);
+    }
+
+    void LoadModel() {
+        enemy = new Model(ENEMY_MODEL_PATH);
+
+    }
+    void LoadTexture() {
+        diffuseMap = new Texture("res/texture/airen.jpg");
+
+    }
+    void LoadShader()
+    {
+        enemyShader = new Shader("res/shader/enemy.vert", "res/shader/enemy.frag");
+        enemyShader->Bind();
+        enemyShader->SetInt("material.diffuse", 0);
+        enemyShader->SetInt("material.specular", 1);
+        enemyShader->SetFloat("material.shininess", 64.0);
+        enemyShader->SetVec3("light.position", vec3(0.0, 400.0, 150.0));
+        enemyShader->SetVec3("light.ambient", vec3(0.2));
+        enemyShader->SetVec3("light.diffuse", vec3(0.65));
+        enemyShader->SetVec3("light.specular", vec3(1.0));
+        enemyShader->SetVec3("viewPos", camera->GetPosition());
+        enemyShader->SetInt("shadowMap_tex", 1); // 告诉着色器 shadowMap_tex 在单元1
+        enemyShader->SetMat4("lightSpaceMatrix", this->lightSpaceMatrix); // <<< 新增：传递 lightSpaceMatrix
+
+        enemyShader->Unbind();
+    }
+};
+#endif // !ENEMYRENDERER_H
@@ -0,0 +1,139 @@
+#ifndef ENTITYSTORE_H
+#define ENTITYSTORE_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <cstddef>
+#include <vector>
+using namespace std;
+#include "simconfig.h"
+#include "slotpool.h"
+
+// Read or write view of a contiguous array. Lets systems walk component arrays in place
+// instead of copying them into vectors.
+template <typename T>
+struct Span {
+    T* data;
+    size_t size;
+
+    Span(T* data, size_t size) : data(data), size(size) {}
+    template <typename U>
+    Span(const Span<U>& other) : data(other.data), size(other.size) {} // Span<T> -> Span<const T>
+    T& operator[](size_t i) const { return data[i]; }
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+    size_t Size() const { return size; }
+    bool Empty() const { return size == 0; }
+};
+
+typedef PoolHandle EntityId;
+
+// How an enemy walks (EnemyOrders::move)
+enum EnemyMove {
+    ENEMY_MOVE_CHASE,       // Along the flow field to the player
+    ENEMY_MOVE_HOLD,        // Stay put, only keep clear of the others
+    ENEMY_MOVE_TO,          // Straight to target
+    ENEMY_MOVE_STRAFE       // Sideways around the player, strafe is +1 or -1
+};
+
+// What an enemy's behavior script asks of movement and shooting. All zero, an enemy
+// chases and fires on its shot timer.
+struct EnemyOrders {
+    unsigned char move;         // EnemyMove
+    unsigned char scriptedFire; // Fires only when its script asks, not on its shot timer
+    unsigned short shots;       // Shots asked for since the last were fired
+    float strafe;
+    vec3 target;
+
+    EnemyOrders() : move(ENEMY_MOVE_CHASE), scriptedFire(0), shots(0), strafe(0.0f), target(0.0f) {}
+};
+
+// Enemies and their shooters. Every entity keeps one stable generational id for its whole
+// life; components live in parallel dense arrays indexed 0..Size()-1 so systems iterate
+// them directly. Removal swaps the last entity into the hole, so dense indices are only
+// valid within one pass; hold an EntityId across frames. All storage is reserved up front.
+class EntityStore {
+private:
+    SlotIndex slots;
+    vector<vec3> position;
+    vector<vec3> velocity;          // Units per second
+    vector<float> angle;            // Facing around y, radians
+    vector<unsigned char> lod;      // Facing update bucket (LodPolicy)
+    vector<EnemyOrders> orders;     // From the behavior scripts
+    vector<EntityId> added;         // Added since the last TakeAdded
+
+public:
+    EntityStore(size_t capacity = DEFAULT_MAX_ENTITIES) : slots(capacity) {
+        position.reserve(capacity);
+        velocity.reserve(capacity);
+        angle.reserve(capacity);
+        lod.reserve(capacity);
+        orders.reserve(capacity);
+    }
+
+    // Returns an invalid id when the store is full
+    EntityId Add(vec3 pos) {
+        EntityId id = slots.Add();
+        if (!id.IsValid())
+            return id;
+        position.push_back(pos);
+        velocity.push_back(vec3(0.0f));
+        angle.push_back(0.0f);
+        lod.push_back(0);
+        orders.push_back(EnemyOrders());
+        added.push_back(id);
+        return id;
+    }
+
+    // Remove the entity at dense index i; the last entity takes its place
+    void RemoveAt(size_t i) {
+        size_t last = slots.RemoveAt(i);
+        if (i != last) {
+            position[i] = position[last];
+            velocity[i] = velocity[last];
+            angle[i] = angle[last];
+            lod[i] = lod[last];
+            orders[i] = orders[last];
+        }
+        position.pop_back();
+        velocity.pop_back();
+        angle.pop_back();
+        lod.pop_back();
+        orders.pop_back();
+    }
+
+    bool Remove(EntityId id) {
+        if (!slots.Contains(id))
+            return false;
+        RemoveAt(slots.IndexOf(id));
+        return true;
+    }
+
+    bool Contains(EntityId id) const { return slots.Contains(id); }
+    size_t IndexOf(EntityId id) const { return slots.IndexOf(id); }
+    size_t IndexOfSlot(unsigned int slot) const { return slots.IndexOfSlot(slot); }
+    EntityId IdAt(size_t i) const { return slots.HandleAt(i); }
+    size_t Size() const { return position.size(); }
+    size_t Capacity() const { return slots.Capacity(); }
+    bool Full() const { return slots.Full(); }
+
+    // Ids added since the last call, in order, for a system that sets up its own state for
+    // new entities (some may have been removed again since). Replaces outIds.
+    void TakeAdded(vector<EntityId>& outIds) {
+        outIds.clear();
+        outIds.swap(added);
+    }
+
+    Span<vec3> Positions() { return Span<vec3>(position.data(), position.size()); }
+    Span<vec3> Velocities() { return Span<vec3>(velocity.data(), velocity.size()); }
+    Span<float> Angles() { return Span<float>(angle.data(), angle.size()); }
+    Span<unsigned char> LodBuckets() { return Span<unsigned char>(lod.data(), lod.size()); }
+    Span<EnemyOrders> Orders() { return Span<EnemyOrders>(orders.data(), orders.size()); }
+
+    Span<const vec3> Positions() const { return Span<const vec3>(position.data(), position.size()); }
+    Span<const vec3> Velocities() const { return Span<const vec3>(velocity.data(), velocity.size()); }
+    Span<const float> Angles() const { return Span<const float>(angle.data(), angle.size()); }
+    Span<const EnemyOrders> Orders() const { return Span<const EnemyOrders>(orders.data(), orders.size()); }
+};
+
+#endif // !ENTITYSTORE_H
@@ -0,0 +1,101 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <vector>
+using namespace std;
+#include "jobsystem.h"
+
+// Gameplay events, drained in this order; within a type as pushed, or by key
+enum GameEventType {
+    GAME_EVENT_ENEMY_KILLED,        // position: the enemy
+    GAME_EVENT_ENEMY_SPAWNED,       // position: the enemy, value: enemies on the field after it
+    GAME_EVENT_BULLET_SHOT_DOWN,    // position: the bullet
+    GAME_EVENT_HEALTH_PACK_SPAWNED, // position: the pack
+    GAME_EVENT_HEALTH_PACK_PICKED,  // position: the pack, amount: its distance to the player
+    GAME_EVENT_PLAYER_HIT,          // position: the bullet, amount: its distance to the player
+    GAME_EVENT_COUNT
+};
+
+inline const char* GameEventName(int type) {
+    static const char* names[GAME_EVENT_COUNT] = { "enemy_killed", "enemy_spawned", "bullet_shot_down", "health_pack_spawned", "health_pack_picked", "player_hit" };
+    return type >= 0 && type < GAME_EVENT_COUNT ? names[type] : "unknown";
+}
+
+struct GameEvent {
+    GameEventType type;
+    unsigned int key;       // Distinct for events of one type pushed from a parallel loop, e.g. the index
+    unsigned int value;
+    float amount;
+    vec3 position;
+
+    GameEvent(GameEventType type, vec3 position = vec3(0.0f), float amount = 0.0f, unsigned int value = 0, unsigned int key = 0)
+        : type(type), key(key), value(value), amount(amount), position(position) {}
+};
+
+// What happened in a tick, for the consumers (score, health, log, audio, telemetry) to take
+// in one batch after it instead of inside the update loops. Systems push from any worker
+// without locks, each thread into its own buffer; Drain gathers them in GameEventType
+// order. Each type is pushed by one job, or with distinct keys from a parallel loop, so
+// the batch is the same on any number of threads.
+class EventBus {
+private:
+    // Own cache lines, so workers pushing side by side do not contend for them
+    struct alignas(64) Buffer {
+        vector<GameEvent> events;
+    };
+
+    JobSystem* jobs;        // Whose workers push, may be NULL: one buffer
+    vector<Buffer> buffers; // Per worker
+    vector<GameEvent> batch;
+
+public:
+    EventBus(JobSystem* jobs) : jobs(jobs), buffers(jobs ? jobs->GetThreadCount() : 1) {}
+
+    // From any of the job system's workers, or the thread that made it
+    void Push(const GameEvent& event) {
+        buffers[jobs ? jobs->GetThreadIndex() : 0].events.push_back(event);
+    }
+
+    // Move everything pushed since the last Drain into the batch, in order. Call while no
+    // system pushes, e.g. between Steps.
+    const vector<GameEvent>& Drain() {
+        // Counting sort by type keeps each buffer's push order and allocates nothing
+        size_t typeStart[GAME_EVENT_COUNT + 1] = {};
+        for (size_t b = 0; b < buffers.size(); b++) {
+            for (size_t i = 0; i < buffers[b].events.size(); i++) {
+                typeStart[buffers[b].events[i].type + 1]++;
+            }
+        }
+        for (int t = 1; t <= GAME_EVENT_COUNT; t++) {
+            typeStart[t] += typeStart[t - 1];
+        }
+        batch.assign(typeStart[GAME_EVENT_COUNT], GameEvent(GAME_EVENT_COUNT));
+        size_t next[GAME_EVENT_COUNT];
+        copy(typeStart, typeStart + GAME_EVENT_COUNT, next);
+        for (size_t b = 0; b < buffers.size(); b++) {
+            for (size_t i = 0; i < buffers[b].events.size(); i++) {
+                batch[next[buffers[b].events[i].type]++] = buffers[b].events[i];
+            }
+            buffers[b].events.clear();
+        }
+        // Events a parallel loop pushed come in whatever order the chunks ran; their keys
+        // are distinct, so sorting by them gives one order
+        auto byKey = [](const GameEvent& a, const GameEvent& b) { return a.key < b.key; };
+        for (int t = 0; t < GAME_EVENT_COUNT; t++) {
+            vector<GameEvent>::iterator begin = batch.begin() + typeStart[t], end = batch.begin() + typeStart[t + 1];
+            if (!is_sorted(begin, end, byKey))
+                sort(begin, end, byKey);
+        }
+        return batch;
+    }
+
+    // The last Drain's events
+    const vector<GameEvent>& GetBatch() const {
+        return batch;
+    }
+};
+
+#endif // !EVENTBUS_H
@@ -0,0 +1,360 @@
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <mutex>
+#include <vector>
+using namespace std;
+#include "cellgrid.h"
+#include "jobsystem.h"
+
+const float NAV_BODY_MIN_Y = 5.0f;      // Room geometry between these heights blocks a cell:
+const float NAV_BODY_MAX_Y = 20.0f;     // above the floor, below the top of an enemy
+const unsigned int NAV_STRAIGHT_COST = 2;   // Step costs; 2:3 is close to 1:sqrt(2)
+const unsigned int NAV_DIAGONAL_COST = 3;
+const unsigned int NAV_BUCKETS = NAV_DIAGONAL_COST + 1; // Ring of distance buckets, one more than the longest step
+const unsigned int NAV_UNREACHED = UINT_MAX;
+const size_t NAV_CHUNK = 1024;          // Cells per parallel chunk
+const size_t NAV_UNLIMITED = (size_t)-1;    // Budget that finishes a build at once
+
+// The 8 neighbours of a cell, straight ones first
+struct NavStep {
+    int dx, dz;
+    unsigned int cost;
+};
+
+const NavStep NAV_STEPS[8] = {
+    { 1, 0, NAV_STRAIGHT_COST }, { -1, 0, NAV_STRAIGHT_COST }, { 0, 1, NAV_STRAIGHT_COST }, { 0, -1, NAV_STRAIGHT_COST },
+    { 1, 1, NAV_DIAGONAL_COST }, { -1, 1, NAV_DIAGONAL_COST }, { 1, -1, NAV_DIAGONAL_COST }, { -1, -1, NAV_DIAGONAL_COST },
+};
+
+// Directions towards the player over a grid on the floor (x/z), blocked where the room's
+// walls and pillars stand at body height. A field is integrated outwards from the
+// player's cell with Dial's algorithm: integer step costs, so the open cells fit a ring of
+// distance buckets and a whole bucket is final at once; its cells relax their neighbours
+// in parallel, lowering distances with an atomic min. Then every cell points at its
+// cheapest neighbour and enemies just look their cell up.
+//
+// Building is spread over ticks, a budget of cells each, into a second buffer that
+// replaces the field in use when done. A new build starts once the player is in another
+// cell. Budgets count cells, not time, so a replay rebuilds on the same ticks.
+class FlowField {
+private:
+    float halfSize;             // Grid covers |x|, |z| up to this
+    float cellSize;
+    int cellsPerSide;
+    vector<unsigned char> blocked;
+
+    vector<vec2> directions;    // Field in use: unit or zero, per cell
+    int target;                 // Cell it leads to, -1 before the first build
+
+    // Build in progress
+    int buildTarget;            // -1 when idle
+    bool integrating;           // Else pointing cells downhill
+    vector<atomic<unsigned int> > distance;
+    vector<unsigned int> buckets[NAV_BUCKETS];  // Cells by distance % NAV_BUCKETS, stale entries included
+    size_t queued;              // Entries in all buckets
+    unsigned int bucketDistance;    // Distance of the bucket to settle next
+    size_t directionCursor;     // Cells pointed so far
+    vector<vec2> building;
+    mutex bucketLock;
+
+    size_t lastWork;            // Cells settled or pointed by the last Update
+    unsigned long long builds;  // Fields completed
+
+public:
+    FlowField(float halfSize, float cellSize)
+        : halfSize(halfSize), cellSize(cellSize), target(-1), buildTarget(-1), integrating(false),
+        queued(0), bucketDistance(0), directionCursor(0), lastWork(0), builds(0) {
+        cellsPerSide = std::max(1, (int)ceil(2.0f * halfSize / cellSize));
+        size_t cells = (size_t)cellsPerSide * cellsPerSide;
+        blocked.assign(cells, 0);
+        directions.assign(cells, vec2(0.0f));
+        building.assign(cells, vec2(0.0f));
+        distance = vector<atomic<unsigned int> >(cells);
+        for (int b = 0; b < (int)NAV_BUCKETS; b++) {
+            buckets[b].reserve(cells);
+        }
+    }
+
+    // Block every cell that the triangles (three vertices each) cross at body height.
+    // Drops the field; the next Retarget builds a new one.
+    void SetObstacles(const vector<vec3>& triangles) {
+        fill(blocked.begin(), blocked.end(), (unsigned char)0);
+        vec3 polygon[5];
+        for (size_t t = 0; t + 2 < triangles.size(); t += 3) {
+            int count = ClipToBody(&triangles[t], polygon);
+            if (count == 0)
+                continue;
+            vec2 lo(polygon[0].x, polygon[0].z), hi = lo;
+            for (int k = 1; k < count; k++) {
+                lo = glm::min(lo, vec2(polygon[k].x, polygon[k].z));
+                hi = glm::max(hi, vec2(polygon[k].x, polygon[k].z));
+            }
+            int x0 = CellCoord(lo.x), x1 = CellCoord(hi.x), z0 = CellCoord(lo.y), z1 = CellCoord(hi.y);
+            for (int z = z0; z <= z1; z++) {
+                for (int x = x0; x <= x1; x++) {
+                    if (!blocked[(size_t)z * cellsPerSide + x] && Overlaps(polygon, count, x, z))
+                        blocked[(size_t)z * cellsPerSide + x] = 1;
+                }
+            }
+        }
+        target = -1;
+        buildTarget = -1;
+        fill(directions.begin(), directions.end(), vec2(0.0f));
+    }
+
+    // Aim at the player's position; starts a build when idle and the player changed cell
+    void Retarget(vec3 playerPos) {
+        int cell = CellIndex(playerPos);
+        if (buildTarget < 0 && cell != target)
+            StartBuild(cell);
+    }
+
+    // Work on the build for about budget cells (whole distance buckets at a time)
+    void Update(JobSystem* jobs, size_t budget) {
+        lastWork = 0;
+        while (buildTarget >= 0 && lastWork < budget) {
+            if (integrating) {
+                if (queued == 0) {
+                    integrating = false;
+                    directionCursor = 0;
+                    continue;
+                }
+                lastWork += SettleBucket(jobs);
+                continue;
+            }
+            size_t cells = building.size();
+            size_t begin = directionCursor;
+            size_t end = budget == NAV_UNLIMITED ? cells : std::min(cells, begin + (budget - lastWork));
+            ParallelFor(jobs, end - begin, NAV_CHUNK, [&](size_t chunkBegin, size_t chunkEnd) {
+                for (size_t c = begin + chunkBegin; c < begin + chunkEnd; c++) {
+                    building[c] = Downhill((int)c);
+                }
+            });
+            lastWork += end - begin;
+            directionCursor = end;
+            if (directionCursor == cells) {
+                directions.swap(building);
+                target = buildTarget;
+                buildTarget = -1;
+                builds++;
+            }
+        }
+    }
+
+    // Unit direction to walk from pos, zero at the target, in unreachable cells and
+    // before the first field is done
+    vec2 Sample(vec3 pos) const {
+        return directions[CellIndex(pos)];
+    }
+
+    // Push away from blocked cells closer than radius to pos: along the offset from each
+    // one's nearest point, 1 - distance/radius long. Zero inside a blocked cell, where
+    // the field already leads out.
+    vec2 Clearance(vec3 pos, float radius) const {
+        vec2 push(0.0f);
+        if (blocked[CellIndex(pos)])
+            return push;
+        vec2 p(pos.x, pos.z);
+        int x0 = CellCoord(pos.x - radius), x1 = CellCoord(pos.x + radius);
+        int z0 = CellCoord(pos.z - radius), z1 = CellCoord(pos.z + radius);
+        for (int z = z0; z <= z1; z++) {
+            for (int x = x0; x <= x1; x++) {
+                if (!blocked[(size_t)z * cellsPerSide + x])
+                    continue;
+                vec2 lo(-halfSize + x * cellSize, -halfSize + z * cellSize);
+                vec2 offset = p - glm::clamp(p, lo, lo + vec2(cellSize));
+                float d = length(offset);
+                if (d > 0.0f && d < radius)
+                    push += offset / d * (1.0f - d / radius);
+            }
+        }
+        return push;
+    }
+
+    bool IsBlocked(vec3 pos) const { return blocked[CellIndex(pos)] != 0; }
+    bool IsBuilding() const { return buildTarget >= 0; }
+    size_t GetLastWork() const { return lastWork; }
+    unsigned long long GetBuildCount() const { return builds; }
+    int GetCellsPerSide() const { return cellsPerSide; }
+    float GetCellSize() const { return cellSize; }
+
+    size_t GetBlockedCount() const {
+        return (size_t)std::count(blocked.begin(), blocked.end(), (unsigned char)1);
+    }
+
+private:
+    int CellCoord(float v) const {
+        return GridCellCoord(v, -halfSize, cellSize, cellsPerSide);
+    }
+
+    int CellIndex(vec3 pos) const {
+        return CellCoord(pos.z) * cellsPerSide + CellCoord(pos.x);
+    }
+
+    void StartBuild(int cell) {
+        for (size_t c = 0; c < distance.size(); c++) {
+            distance[c].store(NAV_UNREACHED, memory_order_relaxed);
+        }
+        for (int b = 0; b < (int)NAV_BUCKETS; b++) {
+            buckets[b].clear();
+        }
+        distance[cell].store(0, memory_order_relaxed);
+        buckets[0].push_back((unsigned int)cell);
+        queued = 1;
+        bucketDistance = 0;
+        buildTarget = cell;
+        integrating = true;
+    }
+
+    // Relax the neighbours of every cell in the next bucket; returns the cells settled.
+    // Steps cost at least 1, so nothing lands in the bucket being worked on. Stale entries
+    // (cells lowered again since) are skipped, and a cell is lowered to each distance at
+    // most once, so the count is the same on any number of threads.
+    size_t SettleBucket(JobSystem* jobs) {
+        vector<unsigned int>& bucket = buckets[bucketDistance % NAV_BUCKETS];
+        unsigned int d = bucketDistance;
+        size_t settled = 0;
+        if (bucket.size() < 2 * NAV_CHUNK) {
+            for (size_t k = 0; k < bucket.size(); k++) {
+                settled += Relax(bucket[k], d, [&](unsigned int cell, unsigned int to) {
+                    buckets[to % NAV_BUCKETS].push_back(cell);
+                    queued++;
+                });
+            }
+        }
+        else {
+            ParallelFor(jobs, bucket.size(), NAV_CHUNK, [&](size_t begin, size_t end) {
+                vector<unsigned int> found[NAV_BUCKETS];
+                size_t chunkSettled = 0;
+                for (size_t k = begin; k < end; k++) {
+                    chunkSettled += Relax(bucket[k], d, [&](unsigned int cell, unsigned int to) {
+                        found[to % NAV_BUCKETS].push_back(cell);
+                    });
+                }
+                lock_guard<mutex> guard(bucketLock);
+                for (int b = 0; b < (int)NAV_BUCKETS; b++) {
+                    buckets[b].insert(buckets[b].end(), found[b].begin(), found[b].end());
+                    queued += found[b].size();
+                }
+                settled += chunkSettled;
+            });
+        }
+        queued -= bucket.size();
+        bucket.clear();
+        bucketDistance++;
+        return settled;
+    }
+
+    // Lower the neighbours of cell, settled at distance d, calling push(neighbour, distance)
+    // for each one lowered. Blocked cells get a distance but pass none on, so enemies
+    // standing in one still find the way out. Returns 0 for a stale entry, else 1.
+    template <typename F>
+    size_t Relax(unsigned int cell, unsigned int d, F push) {
+        if (distance[cell].load(memory_order_relaxed) != d)
+            return 0;
+        if (blocked[cell] && (int)cell != buildTarget)
+            return 1;
+        int x = (int)cell % cellsPerSide, z = (int)cell / cellsPerSide;
+        for (int s = 0; s < 8; s++) {
+            int n = Neighbour(x, z, NAV_STEPS[s]);
+            if (n < 0)
+                continue;
+            unsigned int to = d + NAV_STEPS[s].cost;
+            unsigned int current = distance[n].load(memory_order_relaxed);
+            while (to < current && !distance[n].compare_exchange_weak(current, to, memory_order_relaxed)) {
+            }
+            if (to < current)
+                push((unsigned int)n, to);
+        }
+        return 1;
+    }
+
+    // Cell one step from (x, z), -1 when off the grid or cutting a blocked corner
+    int Neighbour(int x, int z, const NavStep& step) const {
+        int nx = x + step.dx, nz = z + step.dz;
+        if (nx < 0 || nz < 0 || nx >= cellsPerSide || nz >= cellsPerSide)
+            return -1;
+        if (step.dx != 0 && step.dz != 0
+            && (blocked[(size_t)z * cellsPerSide + nx] || blocked[(size_t)nz * cellsPerSide + x]))
+            return -1;
+        return nz * cellsPerSide + nx;
+    }
+
+    // Towards the open neighbour (or the target) with the lowest distance, the first in
+    // NAV_STEPS order on ties
+    vec2 Downhill(int cell) const {
+        unsigned int best = distance[cell].load(memory_order_relaxed);
+        if (best == 0 || best == NAV_UNREACHED)
+            return vec2(0.0f);
+        int x = cell % cellsPerSide, z = cell / cellsPerSide;
+        int bestStep = -1;
+        for (int s = 0; s < 8; s++) {
+            int n = Neighbour(x, z, NAV_STEPS[s]);
+            if (n < 0 || (blocked[n] && n != buildTarget))
+                continue;
+            unsigned int d = distance[n].load(memory_order_relaxed);
+            if (d < best) {
+                best = d;
+                bestStep = s;
+            }
+        }
+        if (bestStep < 0)
+            return vec2(0.0f);
+        return normalize(vec2((float)NAV_STEPS[bestStep].dx, (float)NAV_STEPS[bestStep].dz));
+    }
+
+    // Part of the triangle within the body's heights, as a polygon of up to 5 corners;
+    // returns the corner count, 0 when it lies wholly above or below
+    static int ClipToBody(const vec3* triangle, vec3* out) {
+        vec3 below[4];
+        int count = ClipPlane(triangle, 3, NAV_BODY_MAX_Y, true, below);
+        return count == 0 ? 0 : ClipPlane(below, count, NAV_BODY_MIN_Y, false, out);
+    }
+
+    // Sutherland-Hodgman against y = height, keeping the side below (or above) it
+    static int ClipPlane(const vec3* in, int count, float height, bool keepBelow, vec3* out) {
+        int n = 0;
+        for (int k = 0; k < count; k++) {
+            vec3 a = in[k], b = in[(k + 1) % count];
+            float da = keepBelow ? height - a.y : a.y - height;
+            float db = keepBelow ? height - b.y : b.y - height;
+            if (da >= 0.0f)
+                out[n++] = a;
+            if ((da >= 0.0f) != (db >= 0.0f))
+                out[n++] = a + (b - a) * (da / (da - db));
+        }
+        return n;
+    }
+
+    // Separating axis test of the polygon's x/z outline against cell (x, z). The outline
+    // may be flat (a wall seen from above); zero-length edges give no axis.
+    bool Overlaps(const vec3* polygon, int count, int x, int z) const {
+        vec2 center(-halfSize + (x + 0.5f) * cellSize, -halfSize + (z + 0.5f) * cellSize);
+        float half = 0.5f * cellSize;
+        for (int k = 0; k < count; k++) {
+            vec3 a = polygon[k], b = polygon[(k + 1) % count];
+            vec2 axis(a.z - b.z, b.x - a.x);
+            if (axis.x == 0.0f && axis.y == 0.0f)
+                continue;
+            float lo = dot(axis, vec2(a.x, a.z)), hi = lo;
+            for (int j = 0; j < count; j++) {
+                float p = dot(axis, vec2(polygon[j].x, polygon[j].z));
+                lo = std::min(lo, p);
+                hi = std::max(hi, p);
+            }
+            float c = dot(axis, center), r = half * (abs(axis.x) + abs(axis.y));
+            if (hi <= c - r || lo >= c + r)
+                return false;
+        }
+        return true;
+    }
+};
+
+#endif // !FLOWFIELD_H
@@ -0,0 +1,8 @@
+// Window-less entry point for machines without GL, GLFW or irrKlang:
+//   g++ -O2 -std=c++20 -Ilibrary/include src/headless.cpp -o shootgame-headless
+// The game executable runs the same loop with "Shoot Game.exe --headless".
+#include "headless.h"
+
+int main(int argc, char** argv) {
+    return RunHeadless(argc, argv);
+}
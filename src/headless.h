@@ -0,0 +1,172 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+using namespace std;
+#include "inputreplay.h"
+#include "inputstate.h"
+#include "simulation.h"
+
+// Scripted player for runs without a window: turns steadily, walks a square,
+// jumps, fires in bursts and taps E so every logic path gets exercised.
+InputState ScriptedInput(unsigned long long tick, float tickRate) {
+    float t = tick / tickRate;
+    int side = (int)(t / 2.0f) % 4;
+
+    InputState input;
+    input.forward = (side == 0);
+    input.right = (side == 1);
+    input.back = (side == 2);
+    input.left = (side == 3);
+    input.jump = fmod(t, 3.0f) < 0.1f;
+    input.fire = fmod(t, 1.0f) < 0.5f;
+    input.pickup = fmod(t, 1.0f) < 0.1f;
+    input.mouseDX = 2.0f;
+    input.mouseDY = sin(t);
+    return input;
+}
+
+// Step the simulation at a fixed tick as fast as the CPU allows and print throughput.
+// Options: --ticks N (default one hour at 60 Hz), --hz H, --seed S, --max-bullets N,
+// --simd scalar|sse2|avx2 (cap the kernel level), --threads N (default one per core),
+// --no-lod (turn far enemies every tick too), --behaviors (enemies run behavior scripts;
+// a replay uses the recording's settings for both),
+// --frame-budget MS (pace spawns to hold this step time, SpawnDirector), --verbose (keep
+// game log),
+// --record FILE (save the input played), --replay FILE (play a recording instead of the
+// script, with its seed and tick lengths, to its end unless --ticks is given)
+int RunHeadless(int argc, char** argv) {
+    unsigned long long ticks = 216000;
+    bool ticksGiven = false;
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    float tickRate = 60.0f;
+    unsigned long long seed = (unsigned long long)time(0);
+    SimConfig config;
+    bool verbose = false;
+    bool behaviorsGiven = false;
+    bool lodGiven = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = strtoull(argv[++i], NULL, 10);
+            ticksGiven = true;
+        }
+        else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc)
+            tickRate = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--max-bullets") == 0 && i + 1 < argc)
+            config.maxBullets = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            config.workerThreads = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--simd") == 0 && i + 1 < argc) {
+            SimdLevel level;
+            if (!ParseSimdLevel(argv[++i], level)) {
+                cout << "Unknown SIMD level: " << argv[i] << endl;
+                return 1;
+            }
+            SetSimdLevel(level);
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (strcmp(argv[i], "--no-lod") == 0) {
+            config.lodEnabled = false;
+            lodGiven = true;
+        }
+        else if (strcmp(argv[i], "--behaviors") == 0) {
+            config.enemyBehaviors = true;
+            behaviorsGiven = true;
+        }
+        else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc)
+            config.frameBudgetMs = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+    }
+    if (tickRate <= 0.0f) {
+        cout << "Tick rate must be positive" << endl;
+        return 1;
+    }
+
+    InputReplay replay;
+    if (replayPath) {
+        if (!replay.Open(replayPath))
+            return 1;
+        seed = replay.GetSeed();
+        if (behaviorsGiven && config.enemyBehaviors != replay.GetEnemyBehaviors())
+            cout << "Warning: " << replayPath << " was recorded " << (replay.GetEnemyBehaviors() ? "with" : "without")
+                << " behavior scripts; replaying it that way" << endl;
+        if (lodGiven && config.lodEnabled != replay.GetLodEnabled())
+            cout << "Warning: " << replayPath << " was recorded with LOD; replaying it that way" << endl;
+        replay.ApplyOptions(config);
+        if (!ticksGiven)
+            ticks = ~0ull;
+    }
+    InputRecorder recorder;
+    if (recordPath && !recorder.Open(recordPath, seed, config))
+        return 1;
+
+    if (replayPath)
+        cout << "Replaying " << replayPath << ", seed " << seed
+            << ", " << SimdLevelName(GetSimdLevel()) << " kernels" << endl;
+    else
+        cout << "Headless run: " << ticks << " ticks at " << tickRate << " Hz, seed " << seed
+            << ", " << SimdLevelName(GetSimdLevel()) << " kernels" << endl;
+
+    // Per-event logging would dominate the run, mute it unless asked for
+    streambuf* coutBuffer = cout.rdbuf();
+    if (!verbose)
+        cout.rdbuf(NULL);
+
+    Simulation sim(seed, config);
+    double simSeconds = 0.0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned long long tick = 0; tick < ticks && !sim.IsOver(); tick++) {
+        InputState input;
+        float deltaTime = 1.0f / tickRate;
+        if (replayPath) {
+            DirectorLimits limits = sim.GetLimits();
+            if (!replay.Next(input, deltaTime, limits))
+                break;
+            sim.SetLimits(limits);
+        }
+        else {
+            input = ScriptedInput(tick, tickRate);
+        }
+        sim.Step(input, deltaTime);
+        recorder.Record(input, deltaTime, sim.GetLimits());
+        simSeconds += deltaTime;
+    }
+    double wallSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    recorder.Close();
+
+    cout.rdbuf(coutBuffer);
+    cout.clear();
+
+    cout << "Simulated " << simSeconds / 60.0 << " min in " << wallSeconds << " s ("
+        << (wallSeconds > 0.0 ? simSeconds / 60.0 / wallSeconds : 0.0) << " sim-min/s, "
+        << (sim.GetTickCount() > 0 ? wallSeconds * 1e6 / sim.GetTickCount() : 0.0) << " us/tick, " << sim.GetThreadCount() << " threads)" << endl;
+    cout << "Score: " << sim.GetScore()
+        << "  Health: " << sim.GetPlayerHealth() << "/" << sim.GetMaxPlayerHealth()
+        << "  Enemies: " << sim.GetEnemies()->GetEnemyCount()
+        << "  Bullets: " << sim.GetBalls()->GetBulletCount()
+        << " (dropped " << sim.GetBalls()->GetDroppedBulletCount() << ", shot down " << sim.GetEventTotal(GAME_EVENT_BULLET_SHOT_DOWN) << ")"
+        << "  Health packs: " << sim.GetActiveHealthPackCount() << endl;
+    const SpawnDirector& director = sim.GetDirector();
+    if (director.IsEnabled()) {
+        const DirectorLimits& limits = director.GetLimits();
+        cout << "Director: " << director.GetStats().cuts << " cuts, " << director.GetStats().relaxes << " relaxes; up to "
+            << limits.maxEnemies << " enemies and " << limits.maxHealthPacks << " health packs, spawn intervals x"
+            << limits.spawnIntervalScale << ", fire intervals x" << limits.fireIntervalScale << endl;
+    }
+    return 0;
+}
+
+#endif // !HEADLESS_H
@@ -0,0 +1,128 @@
+#ifndef HEALTHPACKRENDERER_H
+#define HEALTHPACKRENDERER_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include "model.h"
+#include "shader.h"
+#include "camera.h"
+#include "healthpackmanager.h"
+
+// Draws the active health packs of a HealthPackManager. Holds the pentagram model and shader.
+class HealthPackRenderer {
+private:
+    vec2 windowSize;
+    
+    Model* healthPack;
+    Shader* healthPackShader;
+    const HealthPackManager* packs;
+    
+    vec3 lightPos;                      // Light position
+    mat4 lightSpaceMatrix;              // Light space matrix
+    
+    const Camera* camera;
+    // Model transformation matrices
+    mat4 model;
+    mat4 projection;
+    mat4 view;
+    // Spin still to come before the current tick, for drawing between ticks
+    float spinBehind;
+    
+public:
+    HealthPackRenderer(vec2 windowSize, const Camera* camera, const HealthPackManager* packs) : spinBehind(0.0f) {
+        this->windowSize = windowSize;
+        this->camera = camera;
+        this->packs = packs;
+        
+        this->lightPos = vec3(0.0, 400.0, 150.0);
+        mat4 lightProjection = ortho(-100.0f, 100.0f, -100.0f, 100.0f, 1.0f, 500.0f);
+        mat4 lightView = lookAt(lightPos, vec3(0.0f), vec3(0.0, 1.0, 0.0));
+        this->lightSpaceMatrix = lightProjection * lightView;
+        
+        LoadModel();
+    }
+    
+    void Update() {
+        this->view = camera->GetViewMatrix();
+        this->projection = perspective(radians(camera->GetZoom()), windowSize.x / windowSize.y, 0.1f, 500.0f);
+    }
+    
+    // Draw at this fraction of the way from the previous tick to the current one
+    void SetInterpolation(float alpha, float tickLength) {
+        spinBehind = HEALTH_PACK_SPIN_SPEED * tickLength * (1.0f - alpha);
+    }
+    
+    // Render all active health packs
+    void Render(Shader* shaderToUse, GLuint depthMapID = 0) {
+        if (!healthPack || !camera) return;
+        
+        const auto& packSubMeshes = healthPack->GetSubMeshes();
+        if (packSubMeshes.empty()) return;
+        
+        for (const auto& pack : packs->GetHealthPacks()) {
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, pack.position);
+            // Try multiple rotations to orient the pentagram correctly
+            model = glm::rotate(model, glm::radians(pack.rotationY - spinBehind), glm::vec3(0.0f, 1.0f, 0.0f)); // Y rotation for spinning
+            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)); // X rotation to face up
+            model = glm::rotate(model, glm::radians(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)); // Z rotation if needed
+            model = glm::scale(model, glm::vec3(0.6f, 0.6f, 0.6f)); // Larger scale for better visibility
+            
+            Shader* currentShader = shaderToUse;
+            if (currentShader == NULL) {
+                currentShader = healthPackShader;
+                currentShader->Bind();
+                currentShader->SetMat4("projection", projection);
+                currentShader->SetMat4("view", view);
+                currentShader->SetVec3("viewPos", camera->GetPosition());
+            }
+            else {
+                currentShader->Bind();
+            }
+            
+            currentShader->SetMat4("model", model);
+            
+            // Handle texture binding like enemies do
+            if (currentShader == healthPackShader && depthMapID != 0) {
+                glActiveTexture(GL_TEXTURE1);
+                glBindTexture(GL_TEXTURE_2D, depthMapID);
+                currentShader->SetInt("shadowMap_tex", 1);
+            }
+            
+            // Render ALL submeshes to make sure we get the complete model
+            for (const auto& subMesh : packSubMeshes) {
+                glBindVertexArray(subMesh.VAO);
+                glDrawElements(GL_TRIANGLES, subMesh.indexCount, GL_UNSIGNED_INT, 0);
+            }
+        }
+        
+        // Unbind after rendering
+        if (shaderToUse == NULL && healthPackShader) {
+            healthPackShader->Unbind();
+        }
+        glBindVertexArray(0);
+    }
+    
+private:
+    void LoadModel() {
+        // Switch back to pentagram model with proper transformations
+        healthPack = new Model("res/model/WS_Pentagram_obj.obj");
+        // Use enemy shader for proper material and lighting
+        healthPackShader = new Shader("res/shader/enemy.vert", "res/shader/enemy.frag");
+        healthPackShader->Bind();
+        // Set up material properties like enemies do
+        healthPackShader->SetInt("material.diffuse", 0);
+        healthPackShader->SetInt("material.specular", 1);
+        healthPackShader->SetFloat("material.shininess", 64.0);
+        healthPackShader->SetVec3("light.position", lightPos);
+        healthPackShader->SetVec3("light.ambient", vec3(0.2));
+        healthPackShader->SetVec3("light.diffuse", vec3(0.65));
+        healthPackShader->SetVec3("light.specular", vec3(1.0));
+        healthPackShader->SetVec3("viewPos", camera->GetPosition());
+        healthPackShader->SetInt("shadowMap_tex", 1);
+        healthPackShader->SetMat4("lightSpaceMatrix", lightSpaceMatrix);
+        healthPackShader->Unbind();
+    }
+};
+
+#endif // !HEALTHPACKRENDERER_H
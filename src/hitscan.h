@@ -0,0 +1,196 @@
+#ifndef HITSCAN_H
+#define HITSCAN_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+#include "dynamicbvh.h"
+
+const float HITSCAN_RANGE = 500.0f;     // Same reach as the shot ray against bullets
+
+// A shot fired this tick. dir must be unit length.
+struct HitscanRay {
+    vec3 origin;
+    vec3 dir;
+    float maxDistance;
+
+    HitscanRay() : origin(0.0f), dir(0.0f, 0.0f, -1.0f), maxDistance(HITSCAN_RANGE) {}
+    HitscanRay(vec3 origin, vec3 dir, float maxDistance = HITSCAN_RANGE)
+        : origin(origin), dir(dir), maxDistance(maxDistance) {}
+};
+
+// Nearest thing a HitscanRay hit: a tree id (entity slot) and distance, id -1 on a miss
+struct HitscanHit {
+    int id;
+    float distance;
+
+    HitscanHit() : id(-1), distance(0.0f) {}
+    bool IsHit() const { return id >= 0; }
+};
+
+// Upright capsule bounding a model, in the model's frame after scaling: the segment runs
+// from center - halfHeight to center + halfHeight along y. halfHeight 0 is a sphere.
+struct HitCapsule {
+    vec3 center;
+    float halfHeight;
+    float radius;
+
+    HitCapsule() : center(0.0f), halfHeight(0.0f), radius(5.0f) {}
+    HitCapsule(vec3 center, float halfHeight, float radius) : center(center), halfHeight(halfHeight), radius(radius) {}
+
+    // End points of the capsule for an instance at position, turned by angle around y
+    // (the same transform EnemyRenderer draws with)
+    void Segment(vec3 position, float angle, vec3& a, vec3& b) const {
+        float c = cos(angle), s = sin(angle);
+        vec3 mid = position + vec3(c * center.x + s * center.z, center.y, -s * center.x + c * center.z);
+        a = mid - vec3(0.0f, halfHeight, 0.0f);
+        b = mid + vec3(0.0f, halfHeight, 0.0f);
+    }
+
+    // Box holding the capsule at any angle, so turning never moves it in the tree
+    AABB Bounds(vec3 position) const {
+        float reach = length(vec2(center.x, center.z)) + radius;
+        float height = halfHeight + radius;
+        return AABB(position + vec3(-reach, center.y - height, -reach),
+            position + vec3(reach, center.y + height, reach));
+    }
+};
+
+// Fit an upright capsule around mesh vertices (e.g. every SubMesh::vertices of a Model)
+// drawn at the given uniform scale. The axis passes through the middle of the x/z extent.
+HitCapsule ComputeHitCapsule(const vector<vec3>& vertices, float scale) {
+    if (vertices.empty())
+        return HitCapsule();
+    vec3 lo = vertices[0], hi = vertices[0];
+    for (size_t i = 1; i < vertices.size(); i++) {
+        lo = glm::min(lo, vertices[i]);
+        hi = glm::max(hi, vertices[i]);
+    }
+    vec3 center = (lo + hi) * 0.5f;
+    float radiusSq = 0.0f;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        vec2 d = vec2(vertices[i].x - center.x, vertices[i].z - center.z);
+        radiusSq = std::max(radiusSq, dot(d, d));
+    }
+    float radius = sqrt(radiusSq) * scale;
+    float halfHeight = std::max(0.0f, (hi.y - lo.y) * 0.5f * scale - radius);
+    return HitCapsule(center * scale, halfHeight, radius);
+}
+
+// Vertex positions ("v x y z" lines) of an OBJ file, for building hit volumes without
+// loading the mesh into GL. Returns false if the file cannot be read.
+bool ReadObjVertices(const string& path, vector<vec3>& outVertices) {
+    ifstream file(path.c_str());
+    if (!file.is_open())
+        return false;
+    outVertices.clear();
+    string line;
+    while (getline(file, line)) {
+        if (line.size() < 2 || line[0] != 'v' || line[1] != ' ')
+            continue;
+        istringstream in(line.substr(2));
+        vec3 v;
+        if (in >> v.x >> v.y >> v.z)
+            outVertices.push_back(v);
+    }
+    return true;
+}
+
+// Triangles of an OBJ file, three vertices each in outTriangles; polygon faces are split
+// into fans. For collision and navigation without loading the mesh into GL. Returns false
+// if the file cannot be read.
+bool ReadObjTriangles(const string& path, vector<vec3>& outTriangles) {
+    ifstream file(path.c_str());
+    if (!file.is_open())
+        return false;
+    outTriangles.clear();
+    vector<vec3> vertices;
+    vector<int> face;
+    string line;
+    while (getline(file, line)) {
+        if (line.size() < 2 || line[1] != ' ')
+            continue;
+        istringstream in(line.substr(2));
+        if (line[0] == 'v') {
+            vec3 v;
+            if (in >> v.x >> v.y >> v.z)
+                vertices.push_back(v);
+            continue;
+        }
+        if (line[0] != 'f')
+            continue;
+        // "f v", "f v/vt", "f v/vt/vn" or "f v//vn"; negative indices count from the end
+        face.clear();
+        string corner;
+        while (in >> corner) {
+            int index = atoi(corner.c_str());
+            index = index < 0 ? (int)vertices.size() + index : index - 1;
+            if (index < 0 || index >= (int)vertices.size())
+                break;
+            face.push_back(index);
+        }
+        for (size_t k = 2; k < face.size(); k++) {
+            outTriangles.push_back(vertices[face[0]]);
+            outTriangles.push_back(vertices[face[k - 1]]);
+            outTriangles.push_back(vertices[face[k]]);
+        }
+    }
+    return true;
+}
+
+// Distance along a ray (unit dir) to the first point on the capsule a-b of radius r,
+// or -1 when the ray misses or the capsule lies behind the origin. An origin inside
+// the capsule hits at 0.
+float IntersectRayCapsule(vec3 origin, vec3 dir, vec3 a, vec3 b, float r) {
+    vec3 ba = b - a;
+    vec3 oa = origin - a;
+    float baba = dot(ba, ba);
+    float bard = dot(ba, dir);
+    float baoa = dot(ba, oa);
+    float rdoa = dot(dir, oa);
+    float oaoa = dot(oa, oa);
+
+    // Inside already: closest point on the segment is within r
+    float s = baba > 0.0f ? glm::clamp(baoa / baba, 0.0f, 1.0f) : 0.0f;
+    vec3 closest = oa - ba * s;
+    if (dot(closest, closest) <= r * r)
+        return 0.0f;
+
+    // Infinite cylinder around the segment
+    float qa = baba - bard * bard;
+    float qb = baba * rdoa - baoa * bard;
+    float qc = baba * oaoa - baoa * baoa - r * r * baba;
+    if (baba > 0.0f && qa > 1e-8f) {
+        float h = qb * qb - qa * qc;
+        if (h < 0.0f)
+            return -1.0f;
+        float t = (-qb - sqrt(h)) / qa;
+        float y = baoa + t * bard;
+        if (t >= 0.0f && y > 0.0f && y < baba)
+            return t;
+    }
+
+    // End caps: the nearer sphere the ray can reach
+    float best = -1.0f;
+    for (int cap = 0; cap < 2; cap++) {
+        vec3 oc = cap == 0 ? oa : origin - b;
+        float bq = dot(oc, dir);
+        float cq = dot(oc, oc) - r * r;
+        float hq = bq * bq - cq;
+        if (hq < 0.0f)
+            continue;
+        float t = -bq - sqrt(hq);
+        if (t >= 0.0f && (best < 0.0f || t < best))
+            best = t;
+    }
+    return best;
+}
+
+#endif // !HITSCAN_H
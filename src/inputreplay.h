@@ -0,0 +1,322 @@
+#ifndef INPUTREPLAY_H
+#define INPUTREPLAY_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+using namespace std;
+#include "director.h"
+#include "inputstate.h"
+
+// Recorded games for reproducible runs. A file holds the run seed, the game options that
+// change the game (SimConfig::enemyBehaviors and the LOD settings) and, for every tick,
+// the InputState, tick length and spawn limits the simulation was stepped with; playing
+// it back into a Simulation with the same seed repeats the game exactly. Tick lengths and
+// the SpawnDirector's limits come from wall time, so they are recorded like input.
+//
+// Format (little-endian):
+//   header: "SGIR", uint32 version, uint64 seed, uint8 enemy behaviors (0 or 1),
+//           uint8 LOD enabled (0 or 1), float LOD near / mid / far distances
+//   ticks:  one flags byte, then only the fields that differ from the previous tick
+//           (INPUT_DELTA_BUTTONS: button bits byte, INPUT_DELTA_MOUSE_X / _Y / _DELTA_TIME:
+//           raw float; INPUT_DELTA_LIMITS: uint32 max enemies, uint32 max health packs,
+//           float spawn interval scale, float fire interval scale). A run of ticks
+//           identical to the one before is one INPUT_DELTA_REPEAT byte followed by the
+//           run length as a varint.
+// Version 1 files have no limits; they play back with the Simulation's own. Version 1 and 2
+// files have no options byte; they were recorded without behavior scripts. Files before
+// version 4 have no LOD settings; they play back with the default ones.
+
+const char INPUT_REPLAY_MAGIC[4] = { 'S', 'G', 'I', 'R' };
+const uint32_t INPUT_REPLAY_VERSION = 4;
+
+enum InputDeltaFlags {
+    INPUT_DELTA_BUTTONS = 1 << 0,
+    INPUT_DELTA_MOUSE_X = 1 << 1,
+    INPUT_DELTA_MOUSE_Y = 1 << 2,
+    INPUT_DELTA_TIME = 1 << 3,
+    INPUT_DELTA_LIMITS = 1 << 4,
+    INPUT_DELTA_REPEAT = 1 << 7
+};
+
+// Button bits of one tick, in a fixed order shared by writer and reader
+inline unsigned char PackInputButtons(const InputState& input) {
+    return (unsigned char)((input.forward ? 1 : 0) | (input.back ? 2 : 0) | (input.left ? 4 : 0)
+        | (input.right ? 8 : 0) | (input.jump ? 16 : 0) | (input.fire ? 32 : 0)
+        | (input.pickup ? 64 : 0) | (input.screenshot ? 128 : 0));
+}
+
+inline void UnpackInputButtons(unsigned char bits, InputState& input) {
+    input.forward = (bits & 1) != 0;
+    input.back = (bits & 2) != 0;
+    input.left = (bits & 4) != 0;
+    input.right = (bits & 8) != 0;
+    input.jump = (bits & 16) != 0;
+    input.fire = (bits & 32) != 0;
+    input.pickup = (bits & 64) != 0;
+    input.screenshot = (bits & 128) != 0;
+}
+
+// Floats are compared and stored by bit pattern so playback is exact
+inline bool SameFloatBits(float a, float b) {
+    return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+class InputRecorder {
+private:
+    ofstream file;
+    unsigned char lastButtons;
+    float lastMouseDX, lastMouseDY, lastDeltaTime;
+    DirectorLimits lastLimits;          // Zero caps, so the first tick writes the real ones
+    unsigned long long pendingRepeats;  // Ticks equal to the last one, not written yet
+    unsigned long long tickCount;
+
+public:
+    InputRecorder() : lastButtons(0), lastMouseDX(0.0f), lastMouseDY(0.0f), lastDeltaTime(0.0f),
+        pendingRepeats(0), tickCount(0) {}
+
+    ~InputRecorder() {
+        Close();
+    }
+
+    // Start a recording for a run with the given seed and config, of which the header keeps
+    // the options InputReplay::ApplyOptions restores; returns false if the file cannot be
+    // written
+    bool Open(const string& path, unsigned long long seed, const SimConfig& config) {
+        file.open(path.c_str(), ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            cout << "Could not open input recording: " << path << endl;
+            return false;
+        }
+        file.write(INPUT_REPLAY_MAGIC, sizeof(INPUT_REPLAY_MAGIC));
+        WriteRaw(INPUT_REPLAY_VERSION);
+        WriteRaw((uint64_t)seed);
+        WriteRaw((uint8_t)(config.enemyBehaviors ? 1 : 0));
+        WriteRaw((uint8_t)(config.lodEnabled ? 1 : 0));
+        WriteRaw(config.lodNearDistance);
+        WriteRaw(config.lodMidDistance);
+        WriteRaw(config.lodFarDistance);
+        return true;
+    }
+
+    bool IsOpen() const {
+        return file.is_open();
+    }
+
+    // Append one tick, with the limits it ran with (Simulation::GetLimits after its Step)
+    void Record(const InputState& input, float deltaTime, const DirectorLimits& limits) {
+        if (!file.is_open())
+            return;
+        tickCount++;
+        unsigned char buttons = PackInputButtons(input);
+        unsigned char flags = 0;
+        if (buttons != lastButtons) flags |= INPUT_DELTA_BUTTONS;
+        if (!SameFloatBits(input.mouseDX, lastMouseDX)) flags |= INPUT_DELTA_MOUSE_X;
+        if (!SameFloatBits(input.mouseDY, lastMouseDY)) flags |= INPUT_DELTA_MOUSE_Y;
+        if (!SameFloatBits(deltaTime, lastDeltaTime)) flags |= INPUT_DELTA_TIME;
+        if (limits != lastLimits) flags |= INPUT_DELTA_LIMITS;
+        if (flags == 0) {
+            pendingRepeats++;
+            return;
+        }
+
+        FlushRepeats();
+        file.put((char)flags);
+        if (flags & INPUT_DELTA_BUTTONS) file.put((char)buttons);
+        if (flags & INPUT_DELTA_MOUSE_X) WriteRaw(input.mouseDX);
+        if (flags & INPUT_DELTA_MOUSE_Y) WriteRaw(input.mouseDY);
+        if (flags & INPUT_DELTA_TIME) WriteRaw(deltaTime);
+        if (flags & INPUT_DELTA_LIMITS) {
+            WriteRaw((uint32_t)limits.maxEnemies);
+            WriteRaw((uint32_t)limits.maxHealthPacks);
+            WriteRaw(limits.spawnIntervalScale);
+            WriteRaw(limits.fireIntervalScale);
+            lastLimits = limits;
+        }
+        lastButtons = buttons;
+        lastMouseDX = input.mouseDX;
+        lastMouseDY = input.mouseDY;
+        lastDeltaTime = deltaTime;
+    }
+
+    void Close() {
+        if (!file.is_open())
+            return;
+        FlushRepeats();
+        file.close();
+    }
+
+    unsigned long long GetTickCount() const {
+        return tickCount;
+    }
+
+private:
+    template <typename T>
+    void WriteRaw(T value) {
+        file.write((const char*)&value, sizeof(T));
+    }
+
+    void FlushRepeats() {
+        if (pendingRepeats == 0)
+            return;
+        file.put((char)INPUT_DELTA_REPEAT);
+        unsigned long long n = pendingRepeats;
+        while (n >= 0x80) {
+            file.put((char)((n & 0x7F) | 0x80));
+            n >>= 7;
+        }
+        file.put((char)n);
+        pendingRepeats = 0;
+    }
+};
+
+class InputReplay {
+private:
+    ifstream file;
+    unsigned long long seed;
+    SimConfig options;                  // Only the recorded options are read from it
+    uint32_t version;
+    InputState last;
+    float lastDeltaTime;
+    DirectorLimits lastLimits;
+    unsigned long long repeatsLeft;     // Ticks still to replay from the current run
+    unsigned long long tickCount;
+
+public:
+    InputReplay() : seed(0), version(0), lastDeltaTime(0.0f), repeatsLeft(0), tickCount(0) {}
+
+    // Returns false if the file is missing or not a recording
+    bool Open(const string& path) {
+        file.open(path.c_str(), ios::binary);
+        if (!file.is_open()) {
+            cout << "Could not open input recording: " << path << endl;
+            return false;
+        }
+        char magic[4];
+        uint64_t fileSeed = 0;
+        file.read(magic, sizeof(magic));
+        ReadRaw(version);
+        ReadRaw(fileSeed);
+        if (!file || memcmp(magic, INPUT_REPLAY_MAGIC, sizeof(magic)) != 0 || version < 1 || version > INPUT_REPLAY_VERSION) {
+            cout << "Not an input recording (or unsupported version): " << path << endl;
+            file.close();
+            return false;
+        }
+        uint8_t behaviors = 0, lod = 1;
+        options = SimConfig();
+        if (version >= 3)
+            ReadRaw(behaviors);
+        if (version >= 4) {
+            ReadRaw(lod);
+            ReadRaw(options.lodNearDistance);
+            ReadRaw(options.lodMidDistance);
+            ReadRaw(options.lodFarDistance);
+        }
+        if (!file || behaviors > 1 || lod > 1) {
+            cout << "Damaged input recording: " << path << endl;
+            file.close();
+            return false;
+        }
+        seed = (unsigned long long)fileSeed;
+        options.enemyBehaviors = behaviors != 0;
+        options.lodEnabled = lod != 0;
+        return true;
+    }
+
+    bool IsOpen() const {
+        return file.is_open();
+    }
+
+    // Seed the recorded run was started with
+    unsigned long long GetSeed() const {
+        return seed;
+    }
+
+    // Whether the recorded run had behavior scripts...
+    bool GetEnemyBehaviors() const {
+        return options.enemyBehaviors;
+    }
+
+    // ...and LOD; the replay must match them
+    bool GetLodEnabled() const {
+        return options.lodEnabled;
+    }
+
+    // Set the options the recorded run had in config, which the replay's Simulation must
+    // be made with
+    void ApplyOptions(SimConfig& config) const {
+        config.enemyBehaviors = options.enemyBehaviors;
+        config.lodEnabled = options.lodEnabled;
+        config.lodNearDistance = options.lodNearDistance;
+        config.lodMidDistance = options.lodMidDistance;
+        config.lodFarDistance = options.lodFarDistance;
+    }
+
+    // Next tick's input, length and spawn limits (left as they are for a version 1 file);
+    // false once the recording is exhausted
+    bool Next(InputState& input, float& deltaTime, DirectorLimits& limits) {
+        if (!file.is_open())
+            return false;
+        if (repeatsLeft == 0) {
+            int flags = file.get();
+            if (flags == EOF)
+                return false;
+            if (flags & INPUT_DELTA_REPEAT) {
+                if (!ReadVarint(repeatsLeft) || repeatsLeft == 0)
+                    return false;
+            }
+            else {
+                if (flags & INPUT_DELTA_BUTTONS) UnpackInputButtons((unsigned char)file.get(), last);
+                if (flags & INPUT_DELTA_MOUSE_X) ReadRaw(last.mouseDX);
+                if (flags & INPUT_DELTA_MOUSE_Y) ReadRaw(last.mouseDY);
+                if (flags & INPUT_DELTA_TIME) ReadRaw(lastDeltaTime);
+                if (flags & INPUT_DELTA_LIMITS) {
+                    uint32_t maxEnemies = 0, maxHealthPacks = 0;
+                    ReadRaw(maxEnemies);
+                    ReadRaw(maxHealthPacks);
+                    ReadRaw(lastLimits.spawnIntervalScale);
+                    ReadRaw(lastLimits.fireIntervalScale);
+                    lastLimits.maxEnemies = maxEnemies;
+                    lastLimits.maxHealthPacks = maxHealthPacks;
+                }
+                if (!file)
+                    return false;
+                repeatsLeft = 1;
+            }
+        }
+        repeatsLeft--;
+        tickCount++;
+        input = last;
+        deltaTime = lastDeltaTime;
+        if (version >= 2)
+            limits = lastLimits;
+        return true;
+    }
+
+    unsigned long long GetTickCount() const {
+        return tickCount;
+    }
+
+private:
+    template <typename T>
+    void ReadRaw(T& value) {
+        file.read((char*)&value, sizeof(T));
+    }
+
+    bool ReadVarint(unsigned long long& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            int byte = file.get();
+            if (byte == EOF)
+                return false;
+            value |= (unsigned long long)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+};
+
+#endif // !INPUTREPLAY_H
@@ -0,0 +1,23 @@
+#ifndef INPUTSTATE_H
+#define INPUTSTATE_H
+
+// Snapshot of everything the game logic reads from keyboard and mouse in one tick.
+// World fills it from GLFW; headless runs fill it from a script.
+struct InputState {
+    bool forward;       // W
+    bool back;          // S
+    bool left;          // A
+    bool right;         // D
+    bool jump;          // Space
+    bool fire;          // Left mouse button
+    bool pickup;        // E (pick up health pack)
+    bool screenshot;    // I (render side only)
+    float mouseDX;      // Cursor movement since last tick, in pixels
+    float mouseDY;
+
+    InputState()
+        : forward(false), back(false), left(false), right(false), jump(false),
+        fire(false), pickup(false), screenshot(false), mouseDX(0.0f), mouseDY(0.0f) {}
+};
+
+#endif // !INPUTSTATE_H
@@ -0,0 +1,304 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Work-stealing job scheduler. Every worker owns a deque: it pushes and pops its own jobs
+// at the back (newest first, still warm in cache) and idle workers steal from the front of
+// the others (oldest, usually the biggest pieces). The thread that created the JobSystem
+// is worker 0 and runs jobs while it waits, so a JobSystem of one thread starts no threads
+// and runs everything inline.
+//
+// Only the creating thread and the workers may submit work.
+
+class JobSystem;
+
+// One unit of work. Graph nodes and ParallelFor chunks both end up here.
+struct Job {
+    void (*run)(void* context, size_t begin, size_t end);
+    void* context;
+    size_t begin, end;
+    atomic<int> unfinishedDependencies;
+    int dependencyCount;
+    vector<Job*> successors;        // Released when this job finishes
+    atomic<int>* pendingCounter;    // Decremented when this job finishes
+
+    Job() : run(NULL), context(NULL), begin(0), end(0), unfinishedDependencies(0), dependencyCount(0), pendingCounter(NULL) {}
+};
+
+// Jobs with explicit ordering, built once and run any number of times:
+//   int a = graph.Add(...), b = graph.Add(...); graph.Precede(a, b);  // b waits for a
+//   jobs.Run(graph);
+class JobGraph {
+private:
+    deque<function<void()> > work;  // Deques keep addresses stable as nodes are added
+    deque<Job> nodes;
+
+public:
+    int Add(const function<void()>& f) {
+        work.push_back(f);
+        nodes.emplace_back();
+        Job& job = nodes.back();
+        job.run = RunWork;
+        job.context = &work.back();
+        return (int)nodes.size() - 1;
+    }
+
+    // `after` starts only once `before` has finished
+    void Precede(int before, int after) {
+        nodes[before].successors.push_back(&nodes[after]);
+        nodes[after].dependencyCount++;
+    }
+
+    size_t Size() const {
+        return nodes.size();
+    }
+
+    // Run every job on the calling thread in the order they were added. Valid when each
+    // job was added after the jobs it waits for.
+    void RunInline() {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            nodes[i].run(nodes[i].context, 0, 0);
+        }
+    }
+
+private:
+    friend class JobSystem;
+
+    static void RunWork(void* context, size_t, size_t) {
+        (*(function<void()>*)context)();
+    }
+};
+
+class JobSystem {
+private:
+    struct Worker {
+        mutex lock;
+        deque<Job*> jobs;
+    };
+
+    vector<Worker*> workers;
+    vector<thread> threads;
+    atomic<int> queuedJobs;         // Jobs sitting in any deque
+    atomic<int> sleepingWorkers;
+    atomic<bool> stopping;
+    mutex sleepLock;
+    condition_variable wake;
+
+public:
+    // threadCount 0 means one per hardware thread
+    JobSystem(unsigned int threadCount = 0) : queuedJobs(0), sleepingWorkers(0), stopping(false) {
+        if (threadCount == 0)
+            threadCount = thread::hardware_concurrency();
+        if (threadCount == 0)
+            threadCount = 1;
+        for (unsigned int i = 0; i < threadCount; i++) {
+            workers.push_back(new Worker());
+        }
+        CurrentWorker() = 0;
+        CurrentSystem() = this;
+        for (unsigned int i = 1; i < threadCount; i++) {
+            threads.push_back(thread(&JobSystem::WorkerLoop, this, (int)i));
+        }
+    }
+
+    ~JobSystem() {
+        {
+            lock_guard<mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+        for (size_t i = 0; i < workers.size(); i++) {
+            delete workers[i];
+        }
+        if (CurrentSystem() == this)
+            CurrentSystem() = NULL;
+    }
+
+    unsigned int GetThreadCount() const {
+        return (unsigned int)workers.size();
+    }
+
+    // Which worker is calling, in [0, GetThreadCount()); other threads get 0
+    unsigned int GetThreadIndex() {
+        return (unsigned int)WorkerIndex();
+    }
+
+    // Run every job of the graph, respecting Precede, and return when all are done
+    void Run(JobGraph& graph) {
+        if (graph.nodes.empty())
+            return;
+        atomic<int> pending((int)graph.nodes.size());
+        for (size_t i = 0; i < graph.nodes.size(); i++) {
+            Job& job = graph.nodes[i];
+            job.unfinishedDependencies = job.dependencyCount;
+            job.pendingCounter = &pending;
+        }
+        for (size_t i = 0; i < graph.nodes.size(); i++) {
+            if (graph.nodes[i].dependencyCount == 0)
+                Push(&graph.nodes[i]);
+        }
+        Wait(pending);
+    }
+
+    // Call f(begin, end) over [0, count) split into chunks of at least grain items, and
+    // return when all chunks are done. Chunks must not write shared state.
+    template <typename F>
+    void ParallelFor(size_t count, size_t grain, F f) {
+        if (grain == 0)
+            grain = 1;
+        size_t chunks = (count + grain - 1) / grain;
+        size_t maxChunks = workers.size() * 4;  // Enough slack to balance uneven chunks
+        if (chunks > maxChunks)
+            chunks = maxChunks;
+        if (chunks <= 1 || workers.size() == 1) {
+            if (count > 0)
+                f((size_t)0, count);
+            return;
+        }
+
+        vector<Job> jobs(chunks);
+        atomic<int> pending((int)chunks);
+        size_t chunkSize = (count + chunks - 1) / chunks;
+        chunkSize = (chunkSize + 7) & ~(size_t)7;   // Whole SIMD lanes per chunk
+        size_t used = 0;
+        for (size_t c = 0; c < chunks && c * chunkSize < count; c++) {
+            jobs[c].run = RunChunk<F>;
+            jobs[c].context = &f;
+            jobs[c].begin = c * chunkSize;
+            jobs[c].end = std::min(count, (c + 1) * chunkSize);
+            jobs[c].pendingCounter = &pending;
+            used++;
+        }
+        pending -= (int)(chunks - used);
+        // Keep the first chunk for this thread, offer the rest
+        for (size_t c = 1; c < used; c++) {
+            Push(&jobs[c]);
+        }
+        Execute(&jobs[0]);
+        Wait(pending);
+    }
+
+private:
+    template <typename F>
+    static void RunChunk(void* context, size_t begin, size_t end) {
+        (*(F*)context)(begin, end);
+    }
+
+    // Index of the calling thread among this system's workers
+    static int& CurrentWorker() {
+        static thread_local int index = 0;
+        return index;
+    }
+
+    static JobSystem*& CurrentSystem() {
+        static thread_local JobSystem* system = NULL;
+        return system;
+    }
+
+    int WorkerIndex() {
+        return CurrentSystem() == this ? CurrentWorker() : 0;
+    }
+
+    void Push(Job* job) {
+        Worker* worker = workers[WorkerIndex()];
+        {
+            lock_guard<mutex> guard(worker->lock);
+            worker->jobs.push_back(job);
+        }
+        queuedJobs++;
+        if (sleepingWorkers > 0) {
+            { lock_guard<mutex> guard(sleepLock); }
+            wake.notify_one();
+        }
+    }
+
+    // Own newest job first, else the oldest job of another worker
+    Job* Pop() {
+        int self = WorkerIndex();
+        Worker* own = workers[self];
+        {
+            lock_guard<mutex> guard(own->lock);
+            if (!own->jobs.empty()) {
+                Job* job = own->jobs.back();
+                own->jobs.pop_back();
+                queuedJobs--;
+                return job;
+            }
+        }
+        size_t n = workers.size();
+        for (size_t k = 1; k < n; k++) {
+            Worker* victim = workers[(self + k) % n];
+            lock_guard<mutex> guard(victim->lock);
+            if (!victim->jobs.empty()) {
+                Job* job = victim->jobs.front();
+                victim->jobs.pop_front();
+                queuedJobs--;
+                return job;
+            }
+        }
+        return NULL;
+    }
+
+    void Execute(Job* job) {
+        job->run(job->context, job->begin, job->end);
+        for (size_t i = 0; i < job->successors.size(); i++) {
+            if (--job->successors[i]->unfinishedDependencies == 0)
+                Push(job->successors[i]);
+        }
+        // Last touch: the owner may free the job once its counter drops
+        (*job->pendingCounter)--;
+    }
+
+    // Help out until the counter reaches zero
+    void Wait(atomic<int>& pending) {
+        while (pending > 0) {
+            Job* job = Pop();
+            if (job)
+                Execute(job);
+            else
+                this_thread::yield();
+        }
+    }
+
+    void WorkerLoop(int index) {
+        CurrentWorker() = index;
+        CurrentSystem() = this;
+        while (true) {
+            Job* job = Pop();
+            if (job) {
+                Execute(job);
+                continue;
+            }
+            unique_lock<mutex> guard(sleepLock);
+            sleepingWorkers++;
+            wake.wait(guard, [this] { return stopping || queuedJobs > 0; });
+            sleepingWorkers--;
+            if (stopping)
+                return;
+        }
+    }
+};
+
+// jobs->ParallelFor, or one inline call when there is no job system
+template <typename F>
+void ParallelFor(JobSystem* jobs, size_t count, size_t grain, F f) {
+    if (jobs)
+        jobs->ParallelFor(count, grain, f);
+    else if (count > 0)
+        f((size_t)0, count);
+}
+
+#endif // !JOBSYSTEM_H
@@ -1,87 +1,208 @@
 #include <glad/glad.h>
 #include "world.h"
+#include "headless.h"
+#include "benchmark.h"
+#include "soak.h"
 #include <GLFW/glfw3.h>
 
-void OpenWindow();
+const int DEFAULT_WINDOW_WIDTH = 1960;
+const int DEFAULT_WINDOW_HEIGHT = 1080;
+const float DEFAULT_TICK_RATE = 60.0f;  // Simulation ticks per second
+const double MAX_FRAME_TIME = 0.25;     // Longer frames (breakpoints, window drags) are cut, not caught up
+
+void OpenWindow(int width = DEFAULT_WINDOW_WIDTH, int height = DEFAULT_WINDOW_HEIGHT);
 void PrepareOpenGL();
 
 GLFWwindow* window;
 vec2 windowSize;
 
+// Times the full game, simulation and drawing, for "--bench --render" and "--soak --render"
+class WorldBenchmarkRenderer : public BenchmarkRenderer {
+private:
+    World* world;
+
+public:
+    WorldBenchmarkRenderer() : world(NULL) {}
+
+    Simulation* Begin(const BenchmarkScenario& scenario) {
+        if (window == NULL) {
+            OpenWindow(scenario.windowWidth, scenario.windowHeight);
+            PrepareOpenGL();
+            glfwSwapInterval(0); // Measure frames, not the display's refresh
+        }
+        else if ((int)windowSize.x != scenario.windowWidth || (int)windowSize.y != scenario.windowHeight) {
+            glfwSetWindowSize(window, scenario.windowWidth, scenario.windowHeight);
+            windowSize = vec2(scenario.windowWidth, scenario.windowHeight);
+        }
+        world = new World(window, windowSize, scenario.seed, scenario.config);
+        return world->GetSimulation();
+    }
+
+    void Update(const InputState& input, float deltaTime) {
+        world->Advance(input, deltaTime);
+    }
+
+    void Render() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        world->Render();
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    void End() {
+        delete world;
+        world = NULL;
+    }
+};
+
 ISoundEngine* seeyouagain = createIrrKlangDevice();
-int main() {
+int main(int argc, char** argv) {
+    // Run the simulation without a window or GL context
+    const char* recordPath = NULL;
+    const char* replayPath = NULL;
+    int windowWidth = DEFAULT_WINDOW_WIDTH;
+    int windowHeight = DEFAULT_WINDOW_HEIGHT;
+    float tickRate = DEFAULT_TICK_RATE;
+    float frameBudgetMs = 0.0f;     // 0: no director
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0)
+            return RunHeadless(argc, argv);
+        if (strcmp(argv[i], "--bench") == 0) {
+            WorldBenchmarkRenderer renderer;
+            int result = RunBenchmark(argc, argv, &renderer);
+            if (window != NULL)
+                glfwTerminate();
+            return result;
+        }
+        if (strcmp(argv[i], "--soak") == 0) {
+            WorldBenchmarkRenderer renderer;
+            int result = RunSoak(argc, argv, &renderer);
+            if (window != NULL)
+                glfwTerminate();
+            return result;
+        }
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            replayPath = argv[++i];
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+            windowWidth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+            windowHeight = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc)
+            tickRate = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--frame-budget") == 0 && i + 1 < argc)
+            frameBudgetMs = (float)atof(argv[++i]);   // Pace spawns to hold this frame time
+    }
+    if (windowWidth <= 0 || windowHeight <= 0) {
+        cout << "Window size must be positive" << endl;
+        return 1;
+    }
+    if (tickRate <= 0.0f) {
+        cout << "Tick rate must be positive" << endl;
+        return 1;
+    }
+
     // Initialize GLFW
     if (!glfwInit()) {
         cout << "Could not initialize GLFW" << endl;
         return 0;
     }
 
-    const double TARGET_FRAME = 0.016667;
-    const double FRAME_ALPHA = 0.25;
+    // The simulation advances in fixed ticks whatever the frame rate; frames draw
+    // between the last two ticks
+    const float tickLength = 1.0f / tickRate;
     double currentFrame;
-    double deltaTime;
     double lastFrame;
-    double frameTime = 0.0;
-    double renderAccum = 0.0;
-    double smoothFrameTime = TARGET_FRAME;
-
-    srand(time(0));
+    double frameTime;
+    double accumulator = 0.0;   // Real time not simulated yet
+
+    unsigned long long seed = (unsigned long long)time(0);
+    SimConfig config;
+    InputReplay replay;
+    InputRecorder recorder;
+    if (replayPath) {
+        if (!replay.Open(replayPath))
+            return 1;
+        seed = replay.GetSeed();
+        replay.ApplyOptions(config);
+    }
+    if (recordPath && !recorder.Open(recordPath, seed, config))
+        return 1;
+    cout << "Seed: " << seed << endl;
 
     GLuint gameModel = 1;
     cout << "Welcome to the Game!\n";
 
-    OpenWindow();
+    OpenWindow(windowWidth, windowHeight);
     PrepareOpenGL();
 
-    World world(window, windowSize);
+    config.frameBudgetMs = frameBudgetMs;
+    World world(window, windowSize, seed, config);
+    if (replayPath) {
+        world.SetReplay(&replay);
+        glfwSwapInterval(0); // Play back as fast as it renders
+    }
+    if (recordPath)
+        world.SetRecorder(&recorder);
 
     currentFrame = glfwGetTime();
     lastFrame = currentFrame;
 
-    float gameTime = 0;
-
     while (!glfwWindowShouldClose(window) && !glfwGetKey(window, GLFW_KEY_ESCAPE)) {
         currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
+        frameTime = std::min(currentFrame - lastFrame, MAX_FRAME_TIME);
         lastFrame = currentFrame;
-        renderAccum += deltaTime;
-
-        while (!glfwWindowShouldClose(window) && !glfwGetKey(window, GLFW_KEY_ESCAPE)) {
-            double currentFrame = glfwGetTime();
-            deltaTime = currentFrame - lastFrame;
-            lastFrame = currentFrame;
-
-            world.Update(deltaTime);
-
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-            world.Render();
-
-            glfwSwapBuffers(window);
-            glfwPollEvents();
-            if (world.IsOver()) {
-                gangguan->play2D("res/audio/seeyouagain.mp3", GL_TRUE);
-                while (!glfwWindowShouldClose(window)) {
-                    glfwPollEvents();
-                    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
-                        glfwSetWindowShouldClose(window, GLFW_TRUE);
-                        break;
-                    }
-                }
+
+        float alpha = 1.0f;
+        if (replayPath) {
+            // One recorded tick per frame, with its recorded length
+            world.Update(tickLength);
+            if (world.IsReplayFinished())
                 break;
+        }
+        else {
+            accumulator += frameTime;
+            while (accumulator >= tickLength && !world.IsOver()) {
+                world.Update(tickLength);
+                accumulator -= tickLength;
             }
+            alpha = (float)(accumulator / tickLength);
+        }
+
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        world.Render(alpha);
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        if (world.IsOver()) {
+            gangguan->play2D("res/audio/seeyouagain.mp3", GL_TRUE);
+            while (!glfwWindowShouldClose(window)) {
+                glfwPollEvents();
+                if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
+                    glfwSetWindowShouldClose(window, GLFW_TRUE);
+                    break;
+                }
+            }
+            break;
         }
     }
     glfwTerminate();
     cout << "----------------------------Your Score: " << world.GetScore() << " ----------------------------" << endl;
     cout << "----------------------------Remaining Health: " << world.GetPlayerHealth() << "/" << world.GetMaxPlayerHealth() << " ----------------------------" << endl;
     cout << "----------------------------Health Packs on Field: " << world.GetActiveHealthPackCount() << " ----------------------------" << endl;
+    const SpawnDirector& director = world.GetSimulation()->GetDirector();
+    if (director.IsEnabled()) {
+        const DirectorLimits& limits = director.GetLimits();
+        cout << "Director: " << director.GetStats().cuts << " cuts, " << director.GetStats().relaxes << " relaxes; up to "
+            << limits.maxEnemies << " enemies and " << limits.maxHealthPacks << " health packs, spawn intervals x"
+            << limits.spawnIntervalScale << ", fire intervals x" << limits.fireIntervalScale << endl;
+    }
     return 0;
 }
 
-void OpenWindow() {
+void OpenWindow(int width, int height) {
     const char* TITLE = "Shoot Game";
-    int WIDTH = 1960;
-    int HEIGHT = 1080;
 
     // ʼGLFW
     if (!glfwInit()) {
@@ -94,7 +215,7 @@ void OpenWindow() {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_REFRESH_RATE, 60);
 
-    window = glfwCreateWindow(WIDTH, HEIGHT, TITLE, NULL, NULL);
+    window = glfwCreateWindow(width, height, TITLE, NULL, NULL);
     if (window == NULL) {
         std::cout << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -112,7 +233,7 @@ void OpenWindow() {
 
     glGetError();
 
-    windowSize = vec2(WIDTH, HEIGHT);
+    windowSize = vec2(width, height);
 }
 
 void PrepareOpenGL() {
@@ -31,13 +31,13 @@ private:
     mat4 lightSpaceMatrix;
     Shader* sunShader;
 
-    Camera* camera;
+    const Camera* camera;
     mat4 model_matrix; // Original model variable
     mat4 projection;
     mat4 view;
 
 public:
-    Place(vec2 windowSize, Camera* camera) : roomScene(nullptr) { // Initialize roomScene
+    Place(vec2 windowSize, const Camera* camera) : roomScene(nullptr) { // Initialize roomScene
         this->windowSize = windowSize;
         this->camera = camera;
         this->lightPos = vec3(0.0, 800.0, 300.0); // Adjusted light position
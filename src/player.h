@@ -23,12 +23,12 @@ private:
 	Shader* dotShader;
 	mat4 dotModel;						// Crosshair model transformation matrix
 	// Camera
-	Camera* camera;
+	const Camera* camera;
 	// Transformation matrices
 	mat4 projection;
 	mat4 view;
 public:
-	Player(vec2 windowSize, Camera* camera) {
+	Player(vec2 windowSize, const Camera* camera) {
 		this->windowSize = windowSize;
 		this->camera = camera;
 		this->gunRecoil = 10.0f;
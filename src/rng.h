@@ -0,0 +1,87 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Seedable random numbers for the simulation. Every subsystem draws from its own stream
+// derived from the run seed, so one system's draws never shift another's and a run can be
+// replayed tick-for-tick from its seed. Nothing here touches the global rand() state.
+
+// Independent streams per subsystem. Append new ones; reordering changes every replay.
+enum RngStream {
+    RNG_STREAM_ENEMY_SPAWN = 1,
+    RNG_STREAM_HEALTH_PACK_SPAWN = 2,
+    RNG_STREAM_SHOOTER_FIRE = 3,
+    RNG_STREAM_ENEMY_BEHAVIOR = 4
+};
+
+// SplitMix64 finalizer: spreads every input bit over the whole output
+inline uint64_t MixBits(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+// Counter-based draw: a pure function of (seed, stream, key, counter). Use it where
+// entities may be processed in any order or on several threads, keying by the entity id
+// and counting by tick, and every run still draws the same numbers.
+inline uint32_t HashRandom(uint64_t seed, uint64_t stream, uint64_t key, uint64_t counter) {
+    uint64_t h = MixBits(seed + 0x9E3779B97F4A7C15ull * stream);
+    h = MixBits(h ^ key);
+    h = MixBits(h ^ counter);
+    return (uint32_t)(h >> 32);
+}
+
+// Uniform integer in [0, n)
+inline uint32_t HashRandomBelow(uint64_t seed, uint64_t stream, uint64_t key, uint64_t counter, uint32_t n) {
+    return (uint32_t)(((uint64_t)HashRandom(seed, stream, key, counter) * n) >> 32);
+}
+
+// PCG32 generator (O'Neill, pcg-random.org): 64-bit state, one of 2^63 streams picked by
+// the stream id. Small, fast and statistically far better than rand().
+class Rng {
+private:
+    uint64_t state;
+    uint64_t increment;     // Odd; selects the stream
+
+public:
+    Rng(uint64_t seed = 0, uint64_t stream = 0) {
+        Seed(seed, stream);
+    }
+
+    void Seed(uint64_t seed, uint64_t stream = 0) {
+        state = 0;
+        increment = (MixBits(stream) << 1) | 1u;
+        Next();
+        state += MixBits(seed);
+        Next();
+    }
+
+    uint32_t Next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + increment;
+        uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorShifted >> rot) | (xorShifted << ((32 - rot) & 31));
+    }
+
+    // Uniform integer in [0, n)
+    uint32_t NextBelow(uint32_t n) {
+        return (uint32_t)(((uint64_t)Next() * n) >> 32);
+    }
+
+    // Uniform float in [0, 1)
+    float NextFloat() {
+        return (Next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform float in [lo, hi)
+    float Range(float lo, float hi) {
+        return lo + (hi - lo) * NextFloat();
+    }
+};
+
+#endif // !RNG_H
@@ -0,0 +1,61 @@
+#ifndef SIMCONFIG_H
+#define SIMCONFIG_H
+
+#include <cstddef>
+
+const size_t DEFAULT_MAX_BULLETS = 100000; // Bullet store capacity unless configured otherwise
+const size_t DEFAULT_MAX_ENTITIES = 100000; // Entity store capacity unless configured otherwise
+
+// Scale and pacing of a game. The defaults are the normal game; benchmark scenarios
+// override them to push entity counts up.
+struct SimConfig {
+    size_t maxBullets;              // Bullet store capacity, shots beyond it are dropped
+    size_t maxEntities;             // Entity store capacity (enemies)
+
+    unsigned int initialEnemies;    // Spawned at the start
+    unsigned int maxEnemies;        // Timed spawning stops at this many
+    unsigned int enemySpawnBatch;   // Enemies added per spawn
+    float enemySpawnInterval;       // Seconds between spawns
+    float enemySpawnRange;          // Enemies spawn with |x|, |z| below this...
+    float enemySafeZone;            // ...and above this, away from the player's start
+    float enemySpacing;             // Minimum distance between enemies
+    float enemyMoveSpeed;           // Units per second enemies walk towards the player...
+    float enemyStopDistance;        // ...until this close
+    float enemySeparation;          // Walking enemies keep about this far apart
+    bool enemyBehaviors;            // Enemies run behavior scripts: patrol, strafe, burst fire
+
+    float navCellSize;              // Flow field cell edge (FlowField)
+    unsigned int navCellsPerTick;   // Flow field build budget, cells per tick
+
+    unsigned int initialHealthPacks;
+    unsigned int maxHealthPacks;    // Active packs on the field at most
+    float healthPackSpawnInterval;  // Seconds between spawns
+
+    float initialFireInterval;      // Seconds until a shooter's first shot, shrinks with score
+    float fireIntervalMin;          // Later intervals are min + [0, spread)
+    float fireIntervalSpread;
+
+    unsigned int workerThreads;     // Threads stepping the simulation, 0 for one per core
+
+    float frameBudgetMs;            // Frame time SpawnDirector holds by pacing spawns, 0: off
+
+    bool lodEnabled;                // Turn distant enemies less often (LodPolicy)
+    float lodNearDistance;          // Within this of the player: every tick
+    float lodMidDistance;           // Within this: every 2nd tick
+    float lodFarDistance;           // Within this: every 4th tick, beyond it every 8th
+
+    SimConfig()
+        : maxBullets(DEFAULT_MAX_BULLETS), maxEntities(DEFAULT_MAX_ENTITIES),
+        initialEnemies(6), maxEnemies(20), enemySpawnBatch(1), enemySpawnInterval(2.0f),
+        enemySpawnRange(40.0f), enemySafeZone(20.0f), enemySpacing(10.0f),
+        enemyMoveSpeed(6.0f), enemyStopDistance(30.0f), enemySeparation(6.0f),
+        enemyBehaviors(false),
+        navCellSize(4.0f), navCellsPerTick(4096),
+        initialHealthPacks(3), maxHealthPacks(10), healthPackSpawnInterval(3.0f),
+        initialFireInterval(2.0f), fireIntervalMin(1.5f), fireIntervalSpread(2.0f),
+        workerThreads(0),
+        frameBudgetMs(0.0f),
+        lodEnabled(true), lodNearDistance(60.0f), lodMidDistance(120.0f), lodFarDistance(240.0f) {}
+};
+
+#endif // !SIMCONFIG_H
@@ -0,0 +1,89 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Runtime selection of the vector instruction set used by the batch kernels.
+// Kernels are compiled for every level the compiler can target; which one runs is
+// decided once at startup from CPUID, so one binary works on any x86 machine.
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#include <cstring>
+
+enum SimdLevel {
+    SIMD_SCALAR = 0,
+    SIMD_SSE2 = 1,
+    SIMD_AVX2 = 2
+};
+
+// Best level this CPU and OS support
+SimdLevel DetectSimdLevel() {
+#if defined(SIMD_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (osxsave && avx && maxLeaf >= 7 && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    if (avx2)
+        return SIMD_AVX2;
+    return sse2 ? SIMD_SSE2 : SIMD_SCALAR;
+#elif defined(SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    return __builtin_cpu_supports("sse2") ? SIMD_SSE2 : SIMD_SCALAR;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+SimdLevel& ActiveSimdLevel() {
+    static SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+// Level the kernels use: the detected one unless lowered for comparison runs
+SimdLevel GetSimdLevel() {
+    return ActiveSimdLevel();
+}
+
+// Force a lower level (never higher than the CPU supports)
+void SetSimdLevel(SimdLevel level) {
+    SimdLevel best = DetectSimdLevel();
+    ActiveSimdLevel() = level > best ? best : level;
+}
+
+const char* SimdLevelName(SimdLevel level) {
+    switch (level) {
+    case SIMD_AVX2: return "avx2";
+    case SIMD_SSE2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+// Parse "scalar", "sse2" or "avx2"; returns false for anything else
+bool ParseSimdLevel(const char* name, SimdLevel& level) {
+    if (strcmp(name, "scalar") == 0) level = SIMD_SCALAR;
+    else if (strcmp(name, "sse2") == 0) level = SIMD_SSE2;
+    else if (strcmp(name, "avx2") == 0) level = SIMD_AVX2;
+    else return false;
+    return true;
+}
+
+#endif // !SIMD_H
@@ -0,0 +1,85 @@
+#ifndef SIMLOD_H
+#define SIMLOD_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <cstddef>
+#include "simconfig.h"
+
+// Update buckets of the simulation level of detail. An entity in bucket b is updated
+// every 2^b ticks: bucket 0 every tick, bucket 3 every 8th.
+const int LOD_BUCKET_COUNT = 4;
+
+// Entities per bucket and how many were updated, for one system over one tick
+struct LodStats {
+    size_t entities[LOD_BUCKET_COUNT];
+    size_t updated;
+
+    LodStats() { Clear(); }
+
+    void Clear() {
+        for (int b = 0; b < LOD_BUCKET_COUNT; b++) {
+            entities[b] = 0;
+        }
+        updated = 0;
+    }
+
+    void Add(const LodStats& other) {
+        for (int b = 0; b < LOD_BUCKET_COUNT; b++) {
+            entities[b] += other.entities[b];
+        }
+        updated += other.updated;
+    }
+
+    size_t Total() const {
+        size_t total = 0;
+        for (int b = 0; b < LOD_BUCKET_COUNT; b++) {
+            total += entities[b];
+        }
+        return total;
+    }
+};
+
+// Picks an entity's bucket from its distance to the player, one bucket coarser when it is
+// behind the camera. Systems store the bucket per entity and only re-pick it when the
+// entity updates, so skipped entities cost one byte test per tick.
+class LodPolicy {
+private:
+    bool enabled;
+    float limitSq[LOD_BUCKET_COUNT - 1];    // Squared distance up to which bucket b is used
+
+public:
+    LodPolicy(const SimConfig& config = SimConfig()) : enabled(config.lodEnabled) {
+        limitSq[0] = config.lodNearDistance * config.lodNearDistance;
+        limitSq[1] = config.lodMidDistance * config.lodMidDistance;
+        limitSq[2] = config.lodFarDistance * config.lodFarDistance;
+    }
+
+    bool IsEnabled() const { return enabled; }
+    float LimitSq(int bucket) const { return limitSq[bucket]; }
+
+    // Ticks between updates of bucket
+    static unsigned int Period(int bucket) {
+        return 1u << bucket;
+    }
+
+    // Whether an entity in bucket updates on this tick. key (a stable per-entity number,
+    // e.g. its slot) spreads a bucket's entities evenly over the ticks of its period.
+    static bool IsDue(int bucket, unsigned long long tick, unsigned int key) {
+        return ((tick + key) & (Period(bucket) - 1)) == 0;
+    }
+
+    // Bucket for an entity at pos seen from eye looking along front
+    int Bucket(vec3 pos, vec3 eye, vec3 front) const {
+        if (!enabled)
+            return 0;
+        vec3 offset = pos - eye;
+        float distSq = dot(offset, offset);
+        // Comparisons rather than branches: buckets of neighbouring entities are unrelated
+        int bucket = (distSq > limitSq[0]) + (distSq > limitSq[1]) + (distSq > limitSq[2])
+            + (dot(offset, front) < 0.0f);  // Out of sight
+        return bucket < LOD_BUCKET_COUNT - 1 ? bucket : LOD_BUCKET_COUNT - 1;
+    }
+};
+
+#endif // !SIMLOD_H
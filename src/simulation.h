@@ -0,0 +1,338 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <chrono>
+#include <iostream>
+#include <vector>
+using namespace std;
+#include "inputstate.h"
+#include "camera.h"
+#include "ballmanager.h"
+#include "director.h"
+#include "enemy.h"
+#include "eventbus.h"
+#include "healthpackmanager.h"
+#include "jobsystem.h"
+#include "simconfig.h"
+#include "staticbvh.h"
+
+const char* const ROOM_MODEL_PATH = "res/model/room7.obj";   // Walls enemies walk around; Place draws it
+
+// Below this many enemies plus bullets a Step is cheaper than waking the workers
+const size_t PARALLEL_STEP_MIN_ENTITIES = 2048;
+
+// Parts of Step timed separately when profiling or the director is on
+enum SimSystem {
+    SIM_SYSTEM_CAMERA,          // Player movement
+    SIM_SYSTEM_BULLETS,         // Enemy shooting, bullet expiry, bullets the player shoots down
+    SIM_SYSTEM_ENEMIES,         // Facing, player shots, spawning
+    SIM_SYSTEM_MOVEMENT,        // Enemies walking: flow field and crowd steering
+    SIM_SYSTEM_NAVIGATION,      // Flow field builds
+    SIM_SYSTEM_HEALTH_PACKS,    // Spawning, rotation, pickup
+    SIM_SYSTEM_PLAYER_HITS,     // Bullets against the player
+    SIM_SYSTEM_BEHAVIORS,       // Enemy behavior scripts
+    SIM_SYSTEM_COUNT
+};
+
+const char* SimSystemName(int system) {
+    static const char* names[SIM_SYSTEM_COUNT] = { "camera", "bullets", "enemies", "movement", "navigation", "health_packs", "player_hits", "behaviors" };
+    return system >= 0 && system < SIM_SYSTEM_COUNT ? names[system] : "unknown";
+}
+
+// GL-free game state: camera physics, enemies, bullets, health packs and player health.
+// World renders it; RunHeadless steps it without a window.
+//
+// Step runs as a job graph: after the camera moves, the shooters and bullets, the enemies'
+// facing, their flow field and the health packs update side by side, and the big
+// per-entity loops are split over the workers. Everything that adds or removes entities
+// stays ordered, so a run is the same on any number of threads. The systems report kills,
+// hits, pickups and spawns to an EventBus; score, player health, totals and the log take
+// them in one batch after the graph has run.
+class Simulation {
+private:
+    JobSystem* jobs;
+    JobGraph stepGraph;
+    Camera* camera;
+    StaticBVH* world;               // Room walls: player collision, bullet impacts, line of sight
+    EntityStore* entities;          // Enemies and their shooters, shared by Enemy and BallManager
+    BallManager* ball;
+    Enemy* enemy;
+    HealthPackManager* healthPacks;
+    EventBus* events;               // What the systems report during a Step
+
+    unsigned int score;             // Enemies killed
+    int playerHealth;
+    int maxPlayerHealth;
+    bool gameOver;
+
+    unsigned long long seed;
+    double gameTime;                // Seconds simulated so far; double so it keeps ms over long sessions
+    unsigned long long tickCount;   // Steps simulated so far
+    bool pickupWasPressed;          // E key state last tick, pickup fires on press only
+
+    // Arguments of the Step in progress, for the graph's jobs
+    InputState stepInput;
+    float stepDeltaTime;
+    unsigned long long eventTotals[GAME_EVENT_COUNT];   // Events of each type so far
+
+    bool profiling;
+    double systemSeconds[SIM_SYSTEM_COUNT]; // Time each system took in the last Step
+
+    SpawnDirector director;         // Paces spawns to the frame budget, if there is one
+    DirectorLimits limits;          // In force: the director's, or a replay's
+    double renderSeconds;           // Reported for the frame since the last Step
+
+public:
+    // Every random draw derives from seed: the same seed and inputs replay the same game
+    Simulation(unsigned long long seed, const SimConfig& config = SimConfig()) : seed(seed), gameTime(0.0), tickCount(0), pickupWasPressed(false),
+        stepDeltaTime(0.0f), profiling(false), director(config), limits(config), renderSeconds(0.0) {
+        for (int i = 0; i < SIM_SYSTEM_COUNT; i++) {
+            systemSeconds[i] = 0.0;
+        }
+        for (int i = 0; i < GAME_EVENT_COUNT; i++) {
+            eventTotals[i] = 0;
+        }
+        score = 0;
+        playerHealth = 10000000;
+        maxPlayerHealth = 10;
+        gameOver = false;
+
+        jobs = new JobSystem(config.workerThreads);
+        events = new EventBus(jobs);
+        camera = new Camera();
+        entities = new EntityStore(config.maxEntities);
+        ball = new BallManager(camera, entities, seed, config);
+        ball->SetJobSystem(jobs);
+        ball->SetEventBus(events);
+        enemy = new Enemy(camera, entities, seed, config);
+        enemy->SetJobSystem(jobs);
+        enemy->SetEventBus(events);
+        vector<vec3> enemyVertices;
+        if (ReadObjVertices(ENEMY_MODEL_PATH, enemyVertices))
+            enemy->SetHitCapsule(ComputeHitCapsule(enemyVertices, ENEMY_MODEL_SCALE));
+        vector<vec3> roomTriangles;
+        world = new StaticBVH();
+        if (ReadObjTriangles(ROOM_MODEL_PATH, roomTriangles)) {
+            world->Build(roomTriangles);
+            enemy->SetObstacles(roomTriangles);
+        }
+        else
+            cout << "No " << ROOM_MODEL_PATH << ", enemies walk straight at the player and nothing stops shots" << endl;
+        camera->SetWorld(world);
+        ball->SetWorld(world);
+        enemy->SetWorld(world);
+        healthPacks = new HealthPackManager(seed, config);
+        healthPacks->SetEventBus(events);
+        BuildStepGraph();
+    }
+
+    ~Simulation() {
+        delete jobs;
+        delete ball;
+        delete enemy;
+        delete healthPacks;
+        delete events;
+        delete entities;
+        delete world;
+        delete camera;
+    }
+
+    // Advance the game by one tick of deltaTime seconds; returns what happened, in
+    // GameEventType order
+    const vector<GameEvent>& Step(const InputState& input, float deltaTime) {
+        if (director.Decide(gameTime, entities->Size(), healthPacks->GetActiveHealthPackCount()))
+            ApplyLimits(director.GetLimits());
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        gameTime += deltaTime;
+        tickCount++;
+        stepInput = input;
+        stepDeltaTime = deltaTime;
+        for (int i = 0; i < SIM_SYSTEM_COUNT; i++) {
+            systemSeconds[i] = 0.0;
+        }
+        if (entities->Size() + ball->GetBulletCount() < PARALLEL_STEP_MIN_ENTITIES)
+            stepGraph.RunInline();
+        else
+            jobs->Run(stepGraph);
+        ApplyEvents(events->Drain());
+        if (director.IsEnabled()) {
+            double stepSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            director.AddFrame(stepSeconds, systemSeconds[SIM_SYSTEM_BULLETS] + systemSeconds[SIM_SYSTEM_PLAYER_HITS], renderSeconds);
+            renderSeconds = 0.0;
+        }
+        return events->GetBatch();
+    }
+
+    // Seconds the host spent drawing the last frame, counted against the frame budget
+    void ReportRenderSeconds(double seconds) { renderSeconds += seconds; }
+
+    // Impose limits instead of the director's, from the next Step on; replays set the
+    // recorded ones every tick. Stops the director.
+    void SetLimits(const DirectorLimits& limits) {
+        director.Disable();
+        ApplyLimits(limits);
+    }
+    // Limits the last Step ran with
+    const DirectorLimits& GetLimits() const { return limits; }
+    const SpawnDirector& GetDirector() const { return director; }
+
+    void SetEnemyHitCapsule(const HitCapsule& capsule) { enemy->SetHitCapsule(capsule); }
+
+    // Time each SimSystem in Step; costs a clock read per system
+    void SetProfiling(bool enabled) { profiling = enabled; }
+    // Seconds the system took in the last Step (0 unless profiling or directing)
+    double GetSystemSeconds(int system) const { return systemSeconds[system]; }
+
+    unsigned int GetThreadCount() const { return jobs->GetThreadCount(); }
+
+    const Camera* GetCamera() const { return camera; }
+    const BallManager* GetBalls() const { return ball; }
+    const Enemy* GetEnemies() const { return enemy; }
+    const EntityStore* GetEntities() const { return entities; }
+    const HealthPackManager* GetHealthPacks() const { return healthPacks; }
+
+    unsigned int GetScore() const { return score; }
+    // Events of the type in all Steps so far
+    unsigned long long GetEventTotal(int type) const { return eventTotals[type]; }
+    bool IsOver() const { return gameOver; }
+    int GetPlayerHealth() const { return playerHealth; }
+    int GetMaxPlayerHealth() const { return maxPlayerHealth; }
+    size_t GetActiveHealthPackCount() const { return healthPacks->GetActiveHealthPackCount(); }
+    double GetGameTime() const { return gameTime; }
+    unsigned long long GetTickCount() const { return tickCount; }
+    unsigned long long GetSeed() const { return seed; }
+
+private:
+    // Jobs of one Step, added in an order RunInline can follow, and what each waits for:
+    //   camera -> behaviors -> shooters -> bullets -> player shots -> enemy movement/spawning
+    //   camera -> enemy facing -> player shots
+    //   camera -> navigation -> enemy movement/spawning
+    //   bullets, player shots -> bullets shot down, player hits
+    //   camera -> health packs
+    void BuildStepGraph() {
+        int cameraJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_CAMERA, [this] { camera->Update(stepDeltaTime, stepInput); });
+        });
+        // Scripts run before the shooters fire what they asked for and enemies walk
+        int behaviorsJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_BEHAVIORS, [this] {
+                enemy->UpdateBehaviors(stepDeltaTime);
+                ball->QueueShots(enemy->GetShotRequests());
+            });
+        });
+        // Score is read before this tick's kills, as the shooters always have
+        int shootersJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_BULLETS, [this] { ball->UpdateShooters(stepDeltaTime, GetScore()); });
+        });
+        int bulletsJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_BULLETS, [this] { ball->UpdateBullets(stepDeltaTime); });
+        });
+        int facingJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_ENEMIES, [this] { enemy->UpdateFacing(); });
+        });
+        int navigationJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_NAVIGATION, [this] { enemy->UpdateNavigation(); });
+        });
+        int shotsJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_ENEMIES, [this] { enemy->UpdateShots(camera->GetPosition(), camera->GetFront(), stepInput.fire); });
+        });
+        int walkJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_MOVEMENT, [this] { enemy->UpdateMovement(stepDeltaTime); });
+            Timed(SIM_SYSTEM_ENEMIES, [this] { enemy->UpdateEnemySpawning(stepDeltaTime); });
+        });
+        int healthPacksJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_HEALTH_PACKS, [this] { UpdateHealthPacks(); });
+        });
+        // Bullets the player's shots went through never reach the player
+        int playerHitsJob = stepGraph.Add([this] {
+            Timed(SIM_SYSTEM_BULLETS, [this] { ball->CheckPlayerShooting(enemy->GetShots()); });
+            Timed(SIM_SYSTEM_PLAYER_HITS, [this] { ball->CheckBulletHitPlayer(); });
+        });
+
+        stepGraph.Precede(cameraJob, behaviorsJob);
+        stepGraph.Precede(behaviorsJob, shootersJob);
+        stepGraph.Precede(shootersJob, bulletsJob);
+        stepGraph.Precede(bulletsJob, shotsJob);        // Shooters read the entities shots remove
+        stepGraph.Precede(cameraJob, facingJob);
+        stepGraph.Precede(facingJob, shotsJob);         // Shots hit the turned hit volumes
+        stepGraph.Precede(cameraJob, navigationJob);
+        stepGraph.Precede(shotsJob, walkJob);           // Shots hit enemies where the player saw them
+        stepGraph.Precede(navigationJob, walkJob);      // Enemies walk the field built this tick
+        stepGraph.Precede(cameraJob, healthPacksJob);
+        stepGraph.Precede(bulletsJob, playerHitsJob);
+        stepGraph.Precede(shotsJob, playerHitsJob);     // Shots end at the enemies they hit
+    }
+
+    void ApplyLimits(const DirectorLimits& limits) {
+        this->limits = limits;
+        enemy->SetSpawnLimits(limits.maxEnemies, limits.spawnIntervalScale);
+        healthPacks->SetSpawnLimits(limits.maxHealthPacks, limits.spawnIntervalScale);
+        ball->SetFireIntervalScale(limits.fireIntervalScale);
+    }
+
+    // Run f, adding its time to the system when profiling or directing
+    template <typename F>
+    void Timed(SimSystem system, F f) {
+        if (!profiling && !director.IsEnabled()) {
+            f();
+            return;
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        f();
+        systemSeconds[system] += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    void UpdateHealthPacks() {
+        healthPacks->Update(stepDeltaTime);
+
+        // Handle health pack pickup (E key)
+        if (stepInput.pickup && !pickupWasPressed)
+            healthPacks->TryPickupHealthPack(camera->GetPosition());
+        pickupWasPressed = stepInput.pickup;
+    }
+
+    // Score, player health, totals and the log, from the tick's events. Pickups come
+    // before hits, as when the health packs ran first.
+    void ApplyEvents(const vector<GameEvent>& batch) {
+        for (size_t i = 0; i < batch.size(); i++) {
+            const GameEvent& event = batch[i];
+            eventTotals[event.type]++;
+            switch (event.type) {
+            case GAME_EVENT_ENEMY_KILLED:
+                score++;
+                cout << "Enemy killed! Current kill count: " << score << endl;
+                break;
+            case GAME_EVENT_ENEMY_SPAWNED:
+                cout << "New enemy spawned! Current enemy count: " << event.value << endl;
+                break;
+            case GAME_EVENT_HEALTH_PACK_SPAWNED:
+                cout << "Health pack spawned at position: (" << event.position.x << ", " << event.position.y << ", " << event.position.z << ")" << endl;
+                break;
+            case GAME_EVENT_HEALTH_PACK_PICKED:
+                cout << "Health pack picked up! Distance: " << event.amount << endl;
+                if (playerHealth < maxPlayerHealth) {
+                    playerHealth++;
+                    cout << "Health restored! Current health: " << playerHealth << "/" << maxPlayerHealth << endl;
+                }
+                else {
+                    cout << "Health is already full!" << endl;
+                }
+                break;
+            case GAME_EVENT_PLAYER_HIT:
+                playerHealth--;
+                cout << "Player hit! Distance: " << event.amount << ", remaining health: " << playerHealth << "/" << maxPlayerHealth << endl;
+                if (playerHealth <= 0 && !gameOver) {
+                    gameOver = true;
+                    cout << "Game Over! Player died!" << endl;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+};
+
+#endif // !SIMULATION_H
@@ -0,0 +1,166 @@
+#ifndef SLOTPOOL_H
+#define SLOTPOOL_H
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// Handle to an item in a SlotPool. Stays valid while the item lives, even when other
+// items are removed; goes stale (Get returns NULL) once the item itself is removed.
+struct PoolHandle {
+    unsigned int slot;
+    unsigned int generation;
+
+    PoolHandle() : slot(0xFFFFFFFFu), generation(0) {}
+    PoolHandle(unsigned int slot, unsigned int generation) : slot(slot), generation(generation) {}
+    bool IsValid() const { return slot != 0xFFFFFFFFu; }
+};
+
+// Slot and generation bookkeeping for a fixed-capacity store whose items live in dense
+// arrays. Owners keep the item data (one array, or several for structure-of-arrays
+// storage) and mirror the moves RemoveAt reports.
+class SlotIndex {
+private:
+    vector<unsigned int> itemSlot;          // Dense index -> slot
+    vector<unsigned int> slotItem;          // Slot -> dense index
+    vector<unsigned int> slotGeneration;    // Bumped every time a slot is freed
+    vector<unsigned int> freeSlots;         // Stack of unused slots
+    size_t count;
+    size_t capacity;
+
+public:
+    SlotIndex(size_t capacity) : count(0), capacity(capacity) {
+        itemSlot.assign(capacity, 0);
+        slotItem.assign(capacity, 0);
+        slotGeneration.assign(capacity, 0);
+        freeSlots.reserve(capacity);
+        for (size_t i = capacity; i > 0; i--) {
+            freeSlots.push_back((unsigned int)(i - 1));
+        }
+    }
+
+    // Claim a slot for a new item at dense index Size() - 1.
+    // Returns an invalid handle, and claims nothing, when full.
+    PoolHandle Add() {
+        if (freeSlots.empty())
+            return PoolHandle();
+        unsigned int slot = freeSlots.back();
+        freeSlots.pop_back();
+        slotItem[slot] = (unsigned int)count;
+        itemSlot[count] = slot;
+        count++;
+        return PoolHandle(slot, slotGeneration[slot]);
+    }
+
+    // Free the item at dense index i. Returns the index of the last item, which the
+    // owner must move into i (swap-and-pop); equals i when i was the last item.
+    size_t RemoveAt(size_t i) {
+        unsigned int slot = itemSlot[i];
+        size_t last = count - 1;
+        if (i != last) {
+            itemSlot[i] = itemSlot[last];
+            slotItem[itemSlot[i]] = (unsigned int)i;
+        }
+        count--;
+        slotGeneration[slot]++;
+        freeSlots.push_back(slot);
+        return last;
+    }
+
+    bool Contains(PoolHandle handle) const {
+        return handle.slot < capacity && slotGeneration[handle.slot] == handle.generation
+            && slotItem[handle.slot] < count && itemSlot[slotItem[handle.slot]] == handle.slot;
+    }
+
+    // Dense index of a live handle; check Contains first
+    size_t IndexOf(PoolHandle handle) const {
+        return slotItem[handle.slot];
+    }
+
+    // Dense index of the item currently in a slot; the slot must be in use
+    size_t IndexOfSlot(unsigned int slot) const {
+        return slotItem[slot];
+    }
+
+    PoolHandle HandleAt(size_t i) const {
+        return PoolHandle(itemSlot[i], slotGeneration[itemSlot[i]]);
+    }
+
+    unsigned int SlotAt(size_t i) const {
+        return itemSlot[i];
+    }
+
+    size_t Size() const { return count; }
+    size_t Capacity() const { return capacity; }
+    bool Full() const { return freeSlots.empty(); }
+};
+
+// Fixed-capacity pool. Live items are kept densely packed for iteration; removing one
+// moves the last item into its place (swap-and-pop), so Add and Remove are O(1).
+// All storage is reserved up front, nothing allocates after construction.
+template <typename T>
+class SlotPool {
+private:
+    vector<T> items;                        // Live items, densely packed
+    SlotIndex slots;
+
+public:
+    SlotPool(size_t capacity) : slots(capacity) {
+        items.reserve(capacity);
+    }
+
+    // Returns an invalid handle when the pool is full
+    PoolHandle Add(const T& item) {
+        PoolHandle handle = slots.Add();
+        if (handle.IsValid())
+            items.push_back(item);
+        return handle;
+    }
+
+    // Remove the item at dense index i. The last item takes its place, so a loop
+    // that removes while iterating must re-visit index i.
+    void RemoveAt(size_t i) {
+        size_t last = slots.RemoveAt(i);
+        if (i != last)
+            items[i] = items[last];
+        items.pop_back();
+    }
+
+    bool Remove(PoolHandle handle) {
+        if (!slots.Contains(handle))
+            return false;
+        RemoveAt(slots.IndexOf(handle));
+        return true;
+    }
+
+    bool Contains(PoolHandle handle) const {
+        return slots.Contains(handle);
+    }
+
+    T* Get(PoolHandle handle) {
+        return slots.Contains(handle) ? &items[slots.IndexOf(handle)] : NULL;
+    }
+
+    const T* Get(PoolHandle handle) const {
+        return slots.Contains(handle) ? &items[slots.IndexOf(handle)] : NULL;
+    }
+
+    PoolHandle HandleAt(size_t i) const {
+        return slots.HandleAt(i);
+    }
+
+    void Clear() {
+        while (!items.empty()) {
+            RemoveAt(items.size() - 1);
+        }
+    }
+
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+    const vector<T>& Items() const { return items; }
+    size_t Size() const { return items.size(); }
+    size_t Capacity() const { return slots.Capacity(); }
+    bool Full() const { return slots.Full(); }
+};
+
+#endif // !SLOTPOOL_H
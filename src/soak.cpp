@@ -0,0 +1,8 @@
+// Window-less soak test, same as "Shoot Game.exe --soak" without --render:
+//   g++ -O2 -std=c++20 -Ilibrary/include src/soak.cpp -o shootgame-soak -pthread
+//   ./shootgame-soak --minutes 480 --out soak.csv
+#include "soak.h"
+
+int main(int argc, char** argv) {
+    return RunSoak(argc, argv);
+}
@@ -0,0 +1,277 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+using namespace std;
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <unistd.h>
+#endif
+#include "benchmark.h"
+
+// Heap calls through operator new since start. Counting replaces the global operator
+// new/delete, so include this header from exactly one translation unit per program.
+inline atomic<unsigned long long>& HeapAllocationCount() {
+    static atomic<unsigned long long> count(0);
+    return count;
+}
+
+inline atomic<unsigned long long>& HeapFreeCount() {
+    static atomic<unsigned long long> count(0);
+    return count;
+}
+
+void* operator new(size_t size) {
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw bad_alloc();
+    HeapAllocationCount().fetch_add(1, memory_order_relaxed);
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    if (p == NULL)
+        return;
+    HeapFreeCount().fetch_add(1, memory_order_relaxed);
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+// Resident set size of this process in bytes, 0 if unknown
+size_t ProcessResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+#else
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+        return 0;
+    unsigned long size = 0, resident = 0;
+    int read = fscanf(statm, "%lu %lu", &size, &resident);
+    fclose(statm);
+    return read == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+// Values watched for drift, one sample per soak window
+enum SoakMetric {
+    SOAK_METRIC_RSS,                // Resident bytes
+    SOAK_METRIC_LIVE_ALLOCATIONS,   // Allocations not freed yet
+    SOAK_METRIC_ALLOCATION_RATE,    // Allocations during the window
+    SOAK_METRIC_ENTITIES,           // Enemies, bullets and health packs
+    SOAK_METRIC_TICK_P99,           // Microseconds
+    SOAK_METRIC_COUNT
+};
+
+struct SoakMetricInfo {
+    const char* name;
+    double maxGrowth;   // Allowed rise over the run, as a fraction of the starting level
+    double floor;       // Levels below this count as this, so small values may wobble
+};
+
+const SoakMetricInfo SOAK_METRICS[SOAK_METRIC_COUNT] = {
+    { "rss_bytes", 0.10, 1048576.0 },
+    { "live_allocations", 0.10, 1000.0 },
+    { "allocations", 0.25, 1000.0 },
+    { "entities", 0.25, 20.0 },
+    { "tick_p99_us", 0.50, 50.0 },
+};
+
+// Rise of the least-squares line through samples from its first to its last sample,
+// relative to the mean of the first quarter (at least floor)
+double SoakTrend(const vector<double>& samples, double floor) {
+    size_t n = samples.size();
+    if (n < 2)
+        return 0.0;
+    double meanX = (n - 1) / 2.0, meanY = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        meanY += samples[i];
+    }
+    meanY /= n;
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        sxy += (i - meanX) * (samples[i] - meanY);
+        sxx += (i - meanX) * (i - meanX);
+    }
+    size_t quarter = std::max((size_t)1, n / 4);
+    double start = 0.0;
+    for (size_t i = 0; i < quarter; i++) {
+        start += samples[i];
+    }
+    start /= quarter;
+    return sxy / sxx * (n - 1) / std::max(start, floor);
+}
+
+// Run the game with scripted input for a long time and check that nothing creeps up.
+// Every window (a simulated minute by default) samples SoakMetric; after the warm-up the
+// trend of each must stay under its limit, else the run fails (exit code 2).
+// Options: --minutes N (simulated, default 480), --scenario FILE (game settings, seed and
+// rate from its first scenario), --hz H, --seed S, --threads N, --window-seconds S,
+// --warmup-minutes N (default 5), --max-growth PCT (one limit for every metric),
+// --out FILE (samples as CSV), --render (needs a renderer, i.e. the game executable),
+// --verbose (keep game log)
+int RunSoak(int argc, char** argv, BenchmarkRenderer* renderer = NULL) {
+    BenchmarkScenario scenario;
+    scenario.name = "soak";
+    double minutes = 480.0;
+    double windowSeconds = 60.0;
+    double warmupMinutes = 5.0;
+    double maxGrowth = -1.0;
+    const char* outPath = NULL;
+    bool render = false;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            vector<BenchmarkScenario> scenarios;
+            if (!LoadBenchmarkScenarios(argv[++i], scenarios))
+                return 1;
+            scenario = scenarios[0];
+        }
+        else if (strcmp(argv[i], "--minutes") == 0 && i + 1 < argc)
+            minutes = atof(argv[++i]);
+        else if (strcmp(argv[i], "--hz") == 0 && i + 1 < argc)
+            scenario.tickRate = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            scenario.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            scenario.config.workerThreads = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--window-seconds") == 0 && i + 1 < argc)
+            windowSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--warmup-minutes") == 0 && i + 1 < argc)
+            warmupMinutes = atof(argv[++i]);
+        else if (strcmp(argv[i], "--max-growth") == 0 && i + 1 < argc)
+            maxGrowth = atof(argv[++i]) / 100.0;
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            outPath = argv[++i];
+        else if (strcmp(argv[i], "--render") == 0)
+            render = true;
+        else if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+    }
+    if (scenario.tickRate <= 0.0f || windowSeconds <= 0.0) {
+        cout << "Tick rate and window length must be positive" << endl;
+        return 1;
+    }
+    if (render && !renderer) {
+        cout << "--render needs the windowed game executable" << endl;
+        return 1;
+    }
+    ofstream csv;
+    if (outPath) {
+        csv.open(outPath);
+        if (!csv.is_open()) {
+            cout << "Could not write " << outPath << endl;
+            return 1;
+        }
+        csv << "minute";
+        for (int m = 0; m < SOAK_METRIC_COUNT; m++) {
+            csv << "," << SOAK_METRICS[m].name;
+        }
+        csv << "\n";
+    }
+
+    typedef chrono::steady_clock Clock;
+    const float deltaTime = 1.0f / scenario.tickRate;
+    const unsigned long long windowTicks = std::max(1ull, (unsigned long long)(windowSeconds * scenario.tickRate + 0.5));
+    const unsigned long long totalTicks = (unsigned long long)(minutes * 60.0 * scenario.tickRate);
+    const size_t warmupWindows = (size_t)(warmupMinutes * 60.0 / windowSeconds);
+    cout << "Soak run: " << minutes << " min at " << scenario.tickRate << " Hz, seed " << scenario.seed
+        << ", a sample every " << windowSeconds << " s" << (render ? ", rendered" : "") << endl;
+
+    // Per-event logging would dominate the run, mute it unless asked for; samples still go
+    // to the console
+    streambuf* coutBuffer = cout.rdbuf();
+    ostream report(coutBuffer);
+    if (!verbose)
+        cout.rdbuf(NULL);
+
+    Simulation* ownSim = NULL;
+    Simulation* sim = renderer && render ? renderer->Begin(scenario) : (ownSim = new Simulation(scenario.seed, scenario.config));
+    vector<double> samples[SOAK_METRIC_COUNT];
+    vector<double> tickSeconds;
+    tickSeconds.reserve((size_t)windowTicks);
+    unsigned long long windowStartAllocations = HeapAllocationCount().load();
+    for (unsigned long long tick = 0; tick < totalTicks && !sim->IsOver(); tick++) {
+        InputState input = ScriptedInput(tick, scenario.tickRate);
+        Clock::time_point start = Clock::now();
+        if (renderer && render) {
+            renderer->Update(input, deltaTime);
+            renderer->Render();
+        }
+        else {
+            sim->Step(input, deltaTime);
+        }
+        tickSeconds.push_back(chrono::duration<double>(Clock::now() - start).count());
+        if (tickSeconds.size() < windowTicks)
+            continue;
+
+        unsigned long long allocations = HeapAllocationCount().load();
+        double values[SOAK_METRIC_COUNT];
+        values[SOAK_METRIC_RSS] = (double)ProcessResidentBytes();
+        values[SOAK_METRIC_LIVE_ALLOCATIONS] = (double)(allocations - HeapFreeCount().load());
+        values[SOAK_METRIC_ALLOCATION_RATE] = (double)(allocations - windowStartAllocations);
+        values[SOAK_METRIC_ENTITIES] = (double)(sim->GetEnemies()->GetEnemyCount()
+            + sim->GetBalls()->GetBulletCount() + sim->GetActiveHealthPackCount());
+        values[SOAK_METRIC_TICK_P99] = ComputeTimingStats(tickSeconds).p99 * 1e6;
+        tickSeconds.clear();
+        windowStartAllocations = HeapAllocationCount().load(); // After the sampling's own
+
+        double minute = (tick + 1) / scenario.tickRate / 60.0;
+        report << "[" << minute << " min]";
+        if (csv.is_open())
+            csv << minute;
+        for (int m = 0; m < SOAK_METRIC_COUNT; m++) {
+            samples[m].push_back(values[m]);
+            report << " " << SOAK_METRICS[m].name << "=" << (unsigned long long)values[m];
+            if (csv.is_open())
+                csv << "," << values[m];
+        }
+        report << endl;
+        if (csv.is_open())
+            csv << "\n";
+    }
+    if (renderer && render)
+        renderer->End();
+    delete ownSim;
+    cout.rdbuf(coutBuffer);
+    cout.clear();
+
+    size_t windows = samples[0].size();
+    if (windows < warmupWindows + 3) {
+        cout << "Soak: " << windows << " samples, too few past the warm-up to judge a trend" << endl;
+        return 0;
+    }
+    bool drifted = false;
+    for (int m = 0; m < SOAK_METRIC_COUNT; m++) {
+        vector<double> settled(samples[m].begin() + warmupWindows, samples[m].end());
+        double limit = maxGrowth >= 0.0 ? maxGrowth : SOAK_METRICS[m].maxGrowth;
+        double trend = SoakTrend(settled, SOAK_METRICS[m].floor);
+        bool ok = trend <= limit;
+        drifted = drifted || !ok;
+        cout << (ok ? "  ok    " : "  DRIFT ") << SOAK_METRICS[m].name << ": " << trend * 100.0
+            << "% over the run (limit " << limit * 100.0 << "%)" << endl;
+    }
+    cout << (drifted ? "Soak failed" : "Soak passed") << endl;
+    return drifted ? 2 : 0;
+}
+
+#endif // !SOAK_H
@@ -0,0 +1,183 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+#include "cellgrid.h"
+
+const float ARENA_HALF_SIZE = 180.0f;  // Matches the clamp in Camera::CheckCollision
+const float GRID_CELL_SIZE = 10.0f;
+
+// Uniform grid over the arena floor (x/z) for proximity queries. Entries are keyed by a
+// caller-chosen id (a stable slot or index) and kept in per-cell linked lists, so moving
+// an entry only relinks it when it crosses into another cell. Positions outside the arena
+// are filed under the nearest edge cell; queries test the exact distance, so results stay
+// correct there, only slower.
+class SpatialGrid {
+private:
+    float minCoord;
+    float cellSize;
+    int cellsPerSide;
+
+    vector<int> cellHead;       // First entry in each cell, -1 when empty
+    vector<int> next;           // Per id: next entry in the same cell
+    vector<int> prev;           // Per id: previous entry in the same cell
+    vector<int> entryCell;      // Per id: cell it is filed under, -1 when not in the grid
+    vector<vec3> entryPos;      // Per id: last known position
+    size_t count;
+
+public:
+    SpatialGrid(size_t capacity = 0, float halfSize = ARENA_HALF_SIZE, float cellSize = GRID_CELL_SIZE)
+        : minCoord(-halfSize), cellSize(cellSize), count(0) {
+        cellsPerSide = (int)ceil(2.0f * halfSize / cellSize);
+        cellHead.assign(cellsPerSide * cellsPerSide, -1);
+        Reserve(capacity);
+    }
+
+    // Make ids below capacity usable without allocating later
+    void Reserve(size_t capacity) {
+        if (capacity <= entryCell.size())
+            return;
+        next.resize(capacity, -1);
+        prev.resize(capacity, -1);
+        entryCell.resize(capacity, -1);
+        entryPos.resize(capacity);
+    }
+
+    void Insert(unsigned int id, vec3 pos) {
+        if (id >= entryCell.size())
+            Reserve(std::max((size_t)id + 1, (size_t)entryCell.size() * 2));
+        if (entryCell[id] >= 0) {
+            Move(id, pos);
+            return;
+        }
+        entryPos[id] = pos;
+        Link(id, CellOf(pos));
+        count++;
+    }
+
+    // Update the position of an entry already in the grid
+    void Move(unsigned int id, vec3 pos) {
+        entryPos[id] = pos;
+        int cell = CellOf(pos);
+        if (cell != entryCell[id]) {
+            Unlink(id);
+            Link(id, cell);
+        }
+    }
+
+    void Remove(unsigned int id) {
+        if (id >= entryCell.size() || entryCell[id] < 0)
+            return;
+        Unlink(id);
+        count--;
+    }
+
+    void Clear() {
+        fill(cellHead.begin(), cellHead.end(), -1);
+        fill(entryCell.begin(), entryCell.end(), -1);
+        count = 0;
+    }
+
+    bool Contains(unsigned int id) const {
+        return id < entryCell.size() && entryCell[id] >= 0;
+    }
+
+    vec3 GetPosition(unsigned int id) const {
+        return entryPos[id];
+    }
+
+    size_t Size() const {
+        return count;
+    }
+
+    // Call f(id, position) for every entry within radius of center. f returns false to stop.
+    template <typename F>
+    void ForEachInRadius(vec3 center, float radius, F f) const {
+        int x0 = CellCoord(center.x - radius), x1 = CellCoord(center.x + radius);
+        int z0 = CellCoord(center.z - radius), z1 = CellCoord(center.z + radius);
+        float radiusSq = radius * radius;
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                for (int id = cellHead[cz * cellsPerSide + cx]; id >= 0; id = next[id]) {
+                    vec3 d = entryPos[id] - center;
+                    if (dot(d, d) <= radiusSq && !f((unsigned int)id, entryPos[id]))
+                        return;
+                }
+            }
+        }
+    }
+
+    // Call f(id, position) for every entry within radius of the segment a-b, visiting only
+    // the cells the segment's footprint covers. f returns false to stop.
+    template <typename F>
+    void ForEachNearSegment(vec3 a, vec3 b, float radius, F f) const {
+        vec3 ab = b - a;
+        float abLenSq = dot(ab, ab);
+        float radiusSq = radius * radius;
+        int x0 = CellCoord(std::min(a.x, b.x) - radius), x1 = CellCoord(std::max(a.x, b.x) + radius);
+        for (int cx = x0; cx <= x1; cx++) {
+            // Part of the segment whose x lies in this column, widened by radius.
+            // Edge columns also hold everything clamped in from outside the arena.
+            float slabMin = (cx == 0) ? -INFINITY : minCoord + cx * cellSize - radius;
+            float slabMax = (cx == cellsPerSide - 1) ? INFINITY : minCoord + (cx + 1) * cellSize + radius;
+            float t0 = 0.0f, t1 = 1.0f;
+            if (fabs(ab.x) > 1e-6f) {
+                float ta = (slabMin - a.x) / ab.x, tb = (slabMax - a.x) / ab.x;
+                t0 = std::max(0.0f, std::min(ta, tb));
+                t1 = std::min(1.0f, std::max(ta, tb));
+                if (t0 > t1)
+                    continue;
+            }
+            else if (a.x < slabMin || a.x > slabMax) {
+                continue;
+            }
+            float za = a.z + ab.z * t0, zb = a.z + ab.z * t1;
+            int z0 = CellCoord(std::min(za, zb) - radius), z1 = CellCoord(std::max(za, zb) + radius);
+            for (int cz = z0; cz <= z1; cz++) {
+                for (int id = cellHead[cz * cellsPerSide + cx]; id >= 0; id = next[id]) {
+                    vec3 ap = entryPos[id] - a;
+                    float t = abLenSq > 0.0f ? glm::clamp(dot(ap, ab) / abLenSq, 0.0f, 1.0f) : 0.0f;
+                    vec3 d = ap - ab * t;
+                    if (dot(d, d) <= radiusSq && !f((unsigned int)id, entryPos[id]))
+                        return;
+                }
+            }
+        }
+    }
+
+private:
+    int CellCoord(float v) const {
+        return GridCellCoord(v, minCoord, cellSize, cellsPerSide);
+    }
+
+    int CellOf(vec3 pos) const {
+        return CellCoord(pos.z) * cellsPerSide + CellCoord(pos.x);
+    }
+
+    void Link(unsigned int id, int cell) {
+        entryCell[id] = cell;
+        prev[id] = -1;
+        next[id] = cellHead[cell];
+        if (cellHead[cell] >= 0)
+            prev[cellHead[cell]] = (int)id;
+        cellHead[cell] = (int)id;
+    }
+
+    void Unlink(unsigned int id) {
+        int cell = entryCell[id];
+        if (prev[id] >= 0)
+            next[prev[id]] = next[id];
+        else
+            cellHead[cell] = next[id];
+        if (next[id] >= 0)
+            prev[next[id]] = prev[id];
+        entryCell[id] = -1;
+    }
+};
+
+#endif // !SPATIALGRID_H
@@ -0,0 +1,170 @@
+#ifndef SPAWNZONE_H
+#define SPAWNZONE_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+#include "cellgrid.h"
+#include "rng.h"
+
+const int SPAWN_SAMPLE_TRIES = 30;  // Candidates tried around each point while sampling
+
+// Where a kind of entity may appear on the floor (x/z)
+struct SpawnZoneShape {
+    float halfSize;     // |x|, |z| below this...
+    float keepOut;      // ...and above this (negative: anywhere in the square)
+    float spacing;      // Minimum distance between two entities of the zone, > 0
+    float height;       // y of spawned entities
+
+    SpawnZoneShape(float halfSize, float keepOut, float spacing, float height)
+        : halfSize(halfSize), keepOut(keepOut), spacing(spacing), height(height) {}
+};
+
+// Spawn points for one zone. The zone is covered once, up front, by a Poisson-disk set of
+// candidate points at least spacing apart (Bridson's sampling over a background grid of
+// one candidate per cell). Each candidate counts the entities closer than spacing; the
+// unblocked ones are kept in a dense free list, so picking a spawn point is O(1) and
+// entities appearing or leaving only touch the few candidates around them. A full zone
+// just has no free candidate: spawning never retries.
+class SpawnZone {
+private:
+    SpawnZoneShape shape;
+    float cellSize;             // spacing / sqrt(2): at most one candidate per cell
+    int cellsPerSide;
+    vector<int> cellCandidate;  // Candidate in each cell, -1 when none
+    vector<vec3> candidates;
+    vector<unsigned int> blockers;  // Per candidate: entities closer than spacing
+    vector<unsigned int> freeList;  // Unblocked candidates
+    vector<int> freeIndex;      // Per candidate: place in freeList, -1 when blocked
+
+public:
+    // Sample the candidates, drawing from rng
+    SpawnZone(const SpawnZoneShape& shape, Rng& rng) : shape(shape) {
+        cellSize = shape.spacing / sqrt(2.0f);
+        cellsPerSide = std::max(1, (int)ceil(2.0f * shape.halfSize / cellSize));
+        cellCandidate.assign((size_t)cellsPerSide * cellsPerSide, -1);
+        Sample(rng);
+        blockers.assign(candidates.size(), 0);
+        freeIndex.resize(candidates.size());
+        freeList.reserve(candidates.size());
+        for (size_t i = 0; i < candidates.size(); i++) {
+            freeIndex[i] = (int)i;
+            freeList.push_back((unsigned int)i);
+        }
+    }
+
+    // Pick a random free spawn point; false when the zone is full. Call Occupy once the
+    // entity is actually there.
+    bool Pick(Rng& rng, vec3& outPos) const {
+        if (freeList.empty())
+            return false;
+        outPos = candidates[freeList[rng.NextBelow((uint32_t)freeList.size())]];
+        return true;
+    }
+
+    // An entity of the zone appeared at pos / left pos
+    void Occupy(vec3 pos) {
+        ForEachCandidateNear(pos, [&](unsigned int c) {
+            if (blockers[c]++ == 0)
+                Unfree(c);
+        });
+    }
+
+    void Release(vec3 pos) {
+        ForEachCandidateNear(pos, [&](unsigned int c) {
+            if (blockers[c] > 0 && --blockers[c] == 0) {
+                freeIndex[c] = (int)freeList.size();
+                freeList.push_back(c);
+            }
+        });
+    }
+
+    size_t FreeCount() const { return freeList.size(); }
+    size_t CandidateCount() const { return candidates.size(); }   // Most entities the zone holds
+    const SpawnZoneShape& GetShape() const { return shape; }
+
+private:
+    bool Inside(float x, float z) const {
+        return abs(x) < shape.halfSize && abs(z) < shape.halfSize
+            && abs(x) > shape.keepOut && abs(z) > shape.keepOut;
+    }
+
+    int CellCoord(float v) const {
+        return GridCellCoord(v, -shape.halfSize, cellSize, cellsPerSide);
+    }
+
+    // Calls f(candidate) for every candidate closer than spacing to pos
+    template <typename F>
+    void ForEachCandidateNear(vec3 pos, F f) const {
+        int x0 = CellCoord(pos.x - shape.spacing), x1 = CellCoord(pos.x + shape.spacing);
+        int z0 = CellCoord(pos.z - shape.spacing), z1 = CellCoord(pos.z + shape.spacing);
+        float spacingSq = shape.spacing * shape.spacing;
+        for (int cz = z0; cz <= z1; cz++) {
+            for (int cx = x0; cx <= x1; cx++) {
+                int c = cellCandidate[(size_t)cz * cellsPerSide + cx];
+                if (c < 0)
+                    continue;
+                float dx = candidates[c].x - pos.x, dz = candidates[c].z - pos.z;
+                if (dx * dx + dz * dz < spacingSq)
+                    f((unsigned int)c);
+            }
+        }
+    }
+
+    void Unfree(unsigned int c) {
+        unsigned int moved = freeList.back();
+        freeList[freeIndex[c]] = moved;
+        freeIndex[moved] = freeIndex[c];
+        freeList.pop_back();
+        freeIndex[c] = -1;
+    }
+
+    // Add a candidate at (x, z) if it is in the zone and spacing away from the others
+    bool TryAdd(float x, float z, vector<unsigned int>& active) {
+        if (!Inside(x, z) || cellCandidate[(size_t)CellCoord(z) * cellsPerSide + CellCoord(x)] >= 0)
+            return false;
+        bool clear = true;
+        ForEachCandidateNear(vec3(x, 0.0f, z), [&](unsigned int) { clear = false; });
+        if (!clear)
+            return false;
+        cellCandidate[(size_t)CellCoord(z) * cellsPerSide + CellCoord(x)] = (int)candidates.size();
+        active.push_back((unsigned int)candidates.size());
+        candidates.push_back(vec3(x, shape.height, z));
+        return true;
+    }
+
+    // Bridson's Poisson-disk sampling. The keep-out cross may split the zone into parts
+    // sampling cannot grow across, so every empty cell also gets a few tries to start a
+    // new patch; that leaves hardly any gap big enough for another candidate.
+    void Sample(Rng& rng) {
+        vector<unsigned int> active;
+        for (int cell = 0; cell < cellsPerSide * cellsPerSide; cell++) {
+            float cellX = -shape.halfSize + (cell % cellsPerSide) * cellSize;
+            float cellZ = -shape.halfSize + (cell / cellsPerSide) * cellSize;
+            for (int t = 0; t < SPAWN_SAMPLE_TRIES && cellCandidate[cell] < 0; t++) {
+                if (TryAdd(rng.Range(cellX, cellX + cellSize), rng.Range(cellZ, cellZ + cellSize), active))
+                    break;
+            }
+            // Grow from the new point until no active point has room around it
+            while (!active.empty()) {
+                size_t a = rng.NextBelow((uint32_t)active.size());
+                vec3 from = candidates[active[a]];
+                bool added = false;
+                for (int t = 0; t < SPAWN_SAMPLE_TRIES && !added; t++) {
+                    float angle = rng.Range(0.0f, 6.2831853f);
+                    float distance = shape.spacing * (1.0f + rng.NextFloat());
+                    added = TryAdd(from.x + distance * cos(angle), from.z + distance * sin(angle), active);
+                }
+                if (!added) {
+                    active[a] = active.back();
+                    active.pop_back();
+                }
+            }
+        }
+    }
+};
+
+#endif // !SPAWNZONE_H
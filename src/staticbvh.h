@@ -0,0 +1,404 @@
+#ifndef STATICBVH_H
+#define STATICBVH_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+#include "dynamicbvh.h"
+
+const int STATIC_BVH_BINS = 12;         // Candidate split planes per axis in the SAH build
+const unsigned int STATIC_BVH_LEAF = 4; // Nodes this small always become leaves
+const int STATIC_BVH_MAX_DEPTH = 48;    // Deeper nodes become leaves; bounds the query stacks
+const size_t STATIC_RAY_CHUNK = 64;     // Queries per parallel chunk when batched on workers
+
+// Closest point to p on triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+inline vec3 ClosestPointOnTriangle(vec3 p, vec3 a, vec3 b, vec3 c) {
+    vec3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+    vec3 bp = p - b;
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+    vec3 cp = p - c;
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// Closest points c1 on segment p1-q1 and c2 on p2-q2 (Ericson 5.1.9)
+inline void ClosestPointsOnSegments(vec3 p1, vec3 q1, vec3 p2, vec3 q2, vec3& c1, vec3& c2) {
+    vec3 d1 = q1 - p1, d2 = q2 - p2, r = p1 - p2;
+    float a = dot(d1, d1), e = dot(d2, d2), f = dot(d2, r);
+    float s = 0.0f, t = 0.0f;
+    if (a <= 1e-12f && e <= 1e-12f) {
+        c1 = p1;
+        c2 = p2;
+        return;
+    }
+    if (a <= 1e-12f) {
+        t = glm::clamp(f / e, 0.0f, 1.0f);
+    }
+    else {
+        float c = dot(d1, r);
+        if (e <= 1e-12f) {
+            s = glm::clamp(-c / a, 0.0f, 1.0f);
+        }
+        else {
+            float b = dot(d1, d2);
+            float denom = a * e - b * b;
+            s = denom > 0.0f ? glm::clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+            t = (b * s + f) / e;
+            if (t < 0.0f) {
+                t = 0.0f;
+                s = glm::clamp(-c / a, 0.0f, 1.0f);
+            }
+            else if (t > 1.0f) {
+                t = 1.0f;
+                s = glm::clamp((b - c) / a, 0.0f, 1.0f);
+            }
+        }
+    }
+    c1 = p1 + d1 * s;
+    c2 = p2 + d2 * t;
+}
+
+// Distance along a ray (any dir) to triangle v0, v0 + e1, v0 + e2, from either side, or -1
+// when it misses within maxT (Moller-Trumbore)
+inline float IntersectRayTriangle(vec3 origin, vec3 dir, float maxT, vec3 v0, vec3 e1, vec3 e2) {
+    vec3 p = cross(dir, e2);
+    float det = dot(e1, p);
+    if (abs(det) < 1e-12f)
+        return -1.0f;
+    float inv = 1.0f / det;
+    vec3 s = origin - v0;
+    float u = dot(s, p) * inv;
+    if (u < 0.0f || u > 1.0f)
+        return -1.0f;
+    vec3 q = cross(s, e1);
+    float v = dot(dir, q) * inv;
+    if (v < 0.0f || u + v > 1.0f)
+        return -1.0f;
+    float t = dot(e2, q) * inv;
+    return t >= 0.0f && t <= maxT ? t : -1.0f;
+}
+
+// Where a capsule touches a triangle
+struct StaticContact {
+    vec3 onSegment;     // Closest points of the capsule's segment...
+    vec3 onTriangle;    // ...and of the triangle
+    float distance;     // Between them; 0 when the segment crosses the triangle
+    vec3 normal;        // Unit triangle normal, towards the segment's start when crossing
+};
+
+// Bounding volume hierarchy over fixed world triangles (the room), for collision, impacts
+// and line of sight. Built once with binned SAH splits and stored flattened: a node's two
+// children sit next to each other in one array, and a leaf's triangles are one run of
+// the reordered triangle array. Queries only read, so any number may run at once.
+class StaticBVH {
+private:
+    struct Node {
+        AABB box;
+        unsigned int first;     // Leaves: first triangle; inner nodes: left child (right is first + 1)
+        unsigned int count;     // Triangles in a leaf, 0 for inner nodes
+    };
+    // Triangle as a corner and two edges, what the ray test wants
+    struct Tri {
+        vec3 v0, e1, e2;
+    };
+
+    vector<Node> nodes;
+    vector<Tri> tris;
+    vector<unsigned int> order; // Build: triangle ids in leaf order
+    vector<AABB> triBoxes;      // Build scratch
+    vector<vec3> centroids;     // Ditto
+
+public:
+    // Build over triangles, three vertices each (ReadObjTriangles, or the corners from
+    // Model::GetAllTriangles). Replaces any earlier build.
+    void Build(const vector<vec3>& triangles) {
+        size_t count = triangles.size() / 3;
+        nodes.clear();
+        tris.clear();
+        order.resize(count);
+        triBoxes.resize(count);
+        centroids.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            vec3 a = triangles[3 * i], b = triangles[3 * i + 1], c = triangles[3 * i + 2];
+            order[i] = (unsigned int)i;
+            triBoxes[i] = AABB(glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c)));
+            centroids[i] = (a + b + c) / 3.0f;
+        }
+        if (count == 0)
+            return;
+        nodes.reserve(2 * count);
+        nodes.push_back(Node());
+        nodes[0].first = 0;
+        nodes[0].count = (unsigned int)count;
+        Subdivide(0, 0);
+
+        tris.resize(count);
+        for (size_t k = 0; k < count; k++) {
+            const vec3* t = &triangles[3 * (size_t)order[k]];
+            tris[k].v0 = t[0];
+            tris[k].e1 = t[1] - t[0];
+            tris[k].e2 = t[2] - t[0];
+        }
+        vector<AABB>().swap(triBoxes);
+        vector<vec3>().swap(centroids);
+    }
+
+    bool IsEmpty() const { return nodes.empty(); }
+    size_t GetTriangleCount() const { return tris.size(); }
+    size_t GetNodeCount() const { return nodes.size(); }
+
+    // Distance along the ray (unit dir) to the nearest triangle, or -1 on a miss within
+    // maxDistance. Children are visited nearest box first, and boxes behind the best hit
+    // so far are skipped.
+    float Raycast(vec3 origin, vec3 dir, float maxDistance) const {
+        if (nodes.empty())
+            return -1.0f;
+        struct Entry {
+            unsigned int node;
+            float enter;
+        };
+        Entry stack[2 * STATIC_BVH_MAX_DEPTH + 2];
+        int top = 0;
+        vec3 invDir = vec3(1.0f) / dir;
+        float best = -1.0f, limit = maxDistance;
+        float rootEnter = RayEnterAABB(origin, invDir, limit, nodes[0].box);
+        if (rootEnter >= 0.0f)
+            stack[top++] = Entry{ 0, rootEnter };
+        while (top > 0) {
+            Entry entry = stack[--top];
+            if (entry.enter > limit)
+                continue;
+            const Node& node = nodes[entry.node];
+            if (node.count > 0) {
+                for (unsigned int k = node.first; k < node.first + node.count; k++) {
+                    float t = IntersectRayTriangle(origin, dir, limit, tris[k].v0, tris[k].e1, tris[k].e2);
+                    if (t >= 0.0f) {
+                        best = t;
+                        limit = t;
+                    }
+                }
+                continue;
+            }
+            float t0 = RayEnterAABB(origin, invDir, limit, nodes[node.first].box);
+            float t1 = RayEnterAABB(origin, invDir, limit, nodes[node.first + 1].box);
+            // Push the farther child first so the nearer one is visited next
+            if (t0 >= 0.0f && t1 >= 0.0f) {
+                bool rightNearer = t1 < t0;
+                stack[top++] = rightNearer ? Entry{ node.first, t0 } : Entry{ node.first + 1, t1 };
+                stack[top++] = rightNearer ? Entry{ node.first + 1, t1 } : Entry{ node.first, t0 };
+            }
+            else if (t0 >= 0.0f) {
+                stack[top++] = Entry{ node.first, t0 };
+            }
+            else if (t1 >= 0.0f) {
+                stack[top++] = Entry{ node.first + 1, t1 };
+            }
+        }
+        return best;
+    }
+
+    // Whether any triangle crosses segment a-b; stops at the first one found, so it is
+    // cheaper than Raycast for line of sight
+    bool SegmentBlocked(vec3 a, vec3 b) const {
+        if (nodes.empty())
+            return false;
+        vec3 d = b - a;
+        float length = sqrt(dot(d, d));
+        if (length <= 0.0f)
+            return false;
+        vec3 dir = d / length;
+        vec3 invDir = vec3(1.0f) / dir;
+        unsigned int stack[2 * STATIC_BVH_MAX_DEPTH + 2];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (RayEnterAABB(a, invDir, length, node.box) < 0.0f)
+                continue;
+            if (node.count == 0) {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+                continue;
+            }
+            for (unsigned int k = node.first; k < node.first + node.count; k++) {
+                if (IntersectRayTriangle(a, dir, length, tris[k].v0, tris[k].e1, tris[k].e2) >= 0.0f)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls f(const StaticContact&) for every triangle closer than radius to the capsule
+    // around segment a-b, in tree order
+    template <typename F>
+    void CapsuleContacts(vec3 a, vec3 b, float radius, F f) const {
+        if (nodes.empty())
+            return;
+        AABB bounds(glm::min(a, b) - vec3(radius), glm::max(a, b) + vec3(radius));
+        unsigned int stack[2 * STATIC_BVH_MAX_DEPTH + 2];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (!Overlaps(node.box, bounds))
+                continue;
+            if (node.count == 0) {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+                continue;
+            }
+            for (unsigned int k = node.first; k < node.first + node.count; k++) {
+                StaticContact contact;
+                if (SegmentTriangleContact(a, b, tris[k], contact) && contact.distance < radius)
+                    f(contact);
+            }
+        }
+    }
+
+private:
+    static bool Overlaps(const AABB& a, const AABB& b) {
+        return all(lessThanEqual(a.min, b.max)) && all(greaterThanEqual(a.max, b.min));
+    }
+
+    // Closest points of segment a-b and a triangle
+    static bool SegmentTriangleContact(vec3 a, vec3 b, const Tri& tri, StaticContact& out) {
+        vec3 n = cross(tri.e1, tri.e2);
+        float area = length(n);
+        if (area <= 0.0f)
+            return false;
+        n /= area;
+        vec3 d = b - a;
+        float segmentLength = length(d);
+        if (segmentLength > 0.0f) {
+            float t = IntersectRayTriangle(a, d / segmentLength, segmentLength, tri.v0, tri.e1, tri.e2);
+            if (t >= 0.0f) {
+                out.onSegment = out.onTriangle = a + d * (t / segmentLength);
+                out.distance = 0.0f;
+                out.normal = dot(a - tri.v0, n) < 0.0f ? -n : n;
+                return true;
+            }
+        }
+        // Otherwise the closest pair has an end of the segment or an edge of the triangle
+        vec3 corners[3] = { tri.v0, tri.v0 + tri.e1, tri.v0 + tri.e2 };
+        out.onSegment = a;
+        out.onTriangle = ClosestPointOnTriangle(a, corners[0], corners[1], corners[2]);
+        float best = dot(out.onTriangle - a, out.onTriangle - a);
+        vec3 onB = ClosestPointOnTriangle(b, corners[0], corners[1], corners[2]);
+        if (dot(onB - b, onB - b) < best) {
+            out.onSegment = b;
+            out.onTriangle = onB;
+            best = dot(onB - b, onB - b);
+        }
+        for (int e = 0; e < 3; e++) {
+            vec3 onSegment, onEdge;
+            ClosestPointsOnSegments(a, b, corners[e], corners[(e + 1) % 3], onSegment, onEdge);
+            float dSq = dot(onSegment - onEdge, onSegment - onEdge);
+            if (dSq < best) {
+                out.onSegment = onSegment;
+                out.onTriangle = onEdge;
+                best = dSq;
+            }
+        }
+        out.distance = sqrt(best);
+        out.normal = dot(out.onSegment - out.onTriangle, n) < 0.0f ? -n : n;
+        return true;
+    }
+
+    // Split node over [first, first + count) of order at the cheapest of the binned SAH
+    // planes, or keep it a leaf when no split beats testing every triangle
+    void Subdivide(unsigned int index, int depth) {
+        unsigned int first = nodes[index].first, count = nodes[index].count;
+        AABB box = triBoxes[order[first]];
+        AABB centerBox(centroids[order[first]], centroids[order[first]]);
+        for (unsigned int k = first + 1; k < first + count; k++) {
+            box = AABB::Union(box, triBoxes[order[k]]);
+            centerBox = AABB::Union(centerBox, AABB(centroids[order[k]], centroids[order[k]]));
+        }
+        nodes[index].box = box;
+        if (count <= STATIC_BVH_LEAF || depth >= STATIC_BVH_MAX_DEPTH)
+            return;
+
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = count * box.SurfaceArea();
+        for (int axis = 0; axis < 3; axis++) {
+            float lo = centerBox.min[axis], extent = centerBox.max[axis] - lo;
+            if (extent <= 0.0f)
+                continue;
+            AABB binBox[STATIC_BVH_BINS];
+            unsigned int binCount[STATIC_BVH_BINS] = {};
+            float scale = STATIC_BVH_BINS / extent;
+            for (unsigned int k = first; k < first + count; k++) {
+                int bin = std::min(STATIC_BVH_BINS - 1, (int)((centroids[order[k]][axis] - lo) * scale));
+                binBox[bin] = binCount[bin]++ == 0 ? triBoxes[order[k]] : AABB::Union(binBox[bin], triBoxes[order[k]]);
+            }
+            // Cost of each plane from a sweep each way: area times triangles on both sides
+            float leftArea[STATIC_BVH_BINS - 1];
+            unsigned int leftCount[STATIC_BVH_BINS - 1];
+            AABB sweep;
+            unsigned int swept = 0;
+            for (int b = 0; b < STATIC_BVH_BINS - 1; b++) {
+                if (binCount[b] > 0)
+                    sweep = swept == 0 ? binBox[b] : AABB::Union(sweep, binBox[b]);
+                swept += binCount[b];
+                leftArea[b] = swept > 0 ? sweep.SurfaceArea() : 0.0f;
+                leftCount[b] = swept;
+            }
+            swept = 0;
+            for (int b = STATIC_BVH_BINS - 1; b > 0; b--) {
+                if (binCount[b] > 0)
+                    sweep = swept == 0 ? binBox[b] : AABB::Union(sweep, binBox[b]);
+                swept += binCount[b];
+                if (swept == 0 || leftCount[b - 1] == 0)
+                    continue;
+                float cost = leftCount[b - 1] * leftArea[b - 1] + swept * sweep.SurfaceArea();
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b;
+                }
+            }
+        }
+        if (bestAxis < 0)
+            return;
+
+        float lo = centerBox.min[bestAxis];
+        float scale = STATIC_BVH_BINS / (centerBox.max[bestAxis] - lo);
+        unsigned int* middle = partition(order.data() + first, order.data() + first + count, [&](unsigned int t) {
+            return std::min(STATIC_BVH_BINS - 1, (int)((centroids[t][bestAxis] - lo) * scale)) < bestSplit;
+        });
+        unsigned int leftCount = (unsigned int)(middle - (order.data() + first));
+        unsigned int left = (unsigned int)nodes.size();
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[left].first = first;
+        nodes[left].count = leftCount;
+        nodes[left + 1].first = first + leftCount;
+        nodes[left + 1].count = count - leftCount;
+        nodes[index].first = left;
+        nodes[index].count = 0;
+        Subdivide(left, depth + 1);
+        Subdivide(left + 1, depth + 1);
+    }
+};
+
+#endif // !STATICBVH_H
@@ -0,0 +1,287 @@
+#ifndef STEERING_H
+#define STEERING_H
+
+#include <glm/glm.hpp>
+using namespace glm;
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+#include "cellgrid.h"
+#include "entitystore.h"
+#include "jobsystem.h"
+#include "simd.h"
+
+const float STEER_SEPARATION_WEIGHT = 1.5f; // Push apart from agents closer than the separation
+const float STEER_COHESION_WEIGHT = 0.25f;  // Pull towards the centre of agents within twice it
+const float STEER_AVOID_WEIGHT = 2.0f;      // Push away from blocked floor
+const float STEER_RESPONSE = 8.0f;          // Per second: how fast velocity turns to the steering
+const int STEER_LANES = 8;                  // Partial sums per agent, one per vector lane at most
+const size_t STEER_CHUNK = 1024;            // Agents per parallel chunk
+
+// Uniform grid of agent positions on the floor (x/z), rebuilt every tick with a counting
+// sort. Each cell's agents sit together in plain x and z arrays (entries), cells in row
+// order, so the three cells of a row are one straight run of two float arrays. The
+// arrays are a snapshot: agents may move while others read it.
+class NeighbourGrid {
+private:
+    float halfSize;             // Grid covers |x|, |z| up to this; beyond, agents share the edge cells
+    float cellSize;
+    int cellsPerSide;
+    CellBuckets buckets;        // Agents by cell
+    vector<unsigned int> cellOf;    // Per agent: its cell, scratch for Build
+    vector<unsigned int> cells;     // Per entry: its cell
+    vector<float> xs, zs;       // Agent positions sorted by cell, in dense order within one;
+                                // STEER_LANES spare entries at the end, so lanes may read past it
+
+public:
+    NeighbourGrid(float halfSize, float cellSize, size_t capacity) : halfSize(halfSize), cellSize(cellSize),
+        cellsPerSide(std::max(1, (int)ceil(2.0f * halfSize / cellSize))),
+        buckets((size_t)cellsPerSide * cellsPerSide, capacity) {
+        cellOf.reserve(capacity);
+        cells.reserve(capacity);
+        xs.reserve(capacity + STEER_LANES);
+        zs.reserve(capacity + STEER_LANES);
+    }
+
+    void Build(Span<const vec3> positions, JobSystem* jobs) {
+        size_t count = positions.size;
+        cellOf.resize(count);
+        cells.resize(count);
+        xs.assign(count + STEER_LANES, 0.0f);
+        zs.assign(count + STEER_LANES, 0.0f);
+        ParallelFor(jobs, count, STEER_CHUNK, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                cellOf[i] = (unsigned int)(CellCoord(positions[i].z) * cellsPerSide + CellCoord(positions[i].x));
+            }
+        });
+        buckets.Build(cellOf);
+        for (size_t i = 0; i < count; i++) {
+            unsigned int k = buckets.EntryOf(i);
+            cells[k] = cellOf[i];
+            xs[k] = positions[i].x;
+            zs[k] = positions[i].z;
+        }
+    }
+
+    int CellCoord(float v) const {
+        return GridCellCoord(v, -halfSize, cellSize, cellsPerSide);
+    }
+
+    // Entries of the (up to) three rows of cells around an entry's cell; returns how many
+    int NeighbourRows(size_t entry, unsigned int* begins, unsigned int* ends) const {
+        int cx = (int)(cells[entry] % cellsPerSide), cz = (int)(cells[entry] / cellsPerSide);
+        int x0 = std::max(cx - 1, 0), x1 = std::min(cx + 1, cellsPerSide - 1);
+        int rows = 0;
+        for (int z = std::max(cz - 1, 0); z <= std::min(cz + 1, cellsPerSide - 1); z++) {
+            begins[rows] = buckets.Begin((size_t)z * cellsPerSide + x0);
+            ends[rows] = buckets.End((size_t)z * cellsPerSide + x1);
+            rows++;
+        }
+        return rows;
+    }
+
+    // Whether an agent was closer than radius to (x, z) at the last Build
+    bool AnyWithin(float x, float z, float radius) const {
+        int x0 = CellCoord(x - radius), x1 = CellCoord(x + radius);
+        int z0 = CellCoord(z - radius), z1 = CellCoord(z + radius);
+        float radiusSq = radius * radius;
+        for (int cz = z0; cz <= z1; cz++) {
+            unsigned int end = buckets.End((size_t)cz * cellsPerSide + x1);
+            for (unsigned int k = buckets.Begin((size_t)cz * cellsPerSide + x0); k < end; k++) {
+                float dx = xs[k] - x, dz = zs[k] - z;
+                if (dx * dx + dz * dz < radiusSq)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    size_t Size() const { return cells.size(); }
+    unsigned int EntryOf(size_t agent) const { return buckets.EntryOf(agent); }
+    const float* X() const { return xs.data(); }
+    const float* Z() const { return zs.data(); }
+};
+
+// Sums over the neighbours of one agent
+struct NeighbourSums {
+    float separationX, separationZ;     // Push away from close agents
+    float centerX, centerZ;             // Sum of the positions of agents in range...
+    float count;                        // ...and how many
+
+    NeighbourSums() : separationX(0.0f), separationZ(0.0f), centerX(0.0f), centerZ(0.0f), count(0.0f) {}
+};
+
+// Per-lane partial sums of one agent; entry k of a row goes to lane (k - row begin) % 8
+struct NeighbourLanes {
+    float separationX[STEER_LANES], separationZ[STEER_LANES];
+    float centerX[STEER_LANES], centerZ[STEER_LANES];
+    float count[STEER_LANES];
+
+    NeighbourLanes() {
+        for (int j = 0; j < STEER_LANES; j++) {
+            separationX[j] = separationZ[j] = centerX[j] = centerZ[j] = count[j] = 0.0f;
+        }
+    }
+};
+
+// Lanes added in a fixed tree, the order 256-bit vector halves fold in
+inline float ReduceLanes(const float* l) {
+    return ((l[0] + l[4]) + (l[2] + l[6])) + ((l[1] + l[5]) + (l[3] + l[7]));
+}
+
+inline NeighbourSums ReduceNeighbourLanes(const NeighbourLanes& lanes) {
+    NeighbourSums sums;
+    sums.separationX = ReduceLanes(lanes.separationX);
+    sums.separationZ = ReduceLanes(lanes.separationZ);
+    sums.centerX = ReduceLanes(lanes.centerX);
+    sums.centerZ = ReduceLanes(lanes.centerZ);
+    sums.count = ReduceLanes(lanes.count);
+    return sums;
+}
+
+// Neighbour sums of grid entries [begin, end), written to out by entry. Agents closer than
+// separation push by (separation/d - d/separation) along the offset, 1.5 at half the
+// distance and 0 at it; agents within twice the separation count towards the centre.
+// The agent itself (offset 0) adds nothing. The neighbours of the 3x3 cells around are
+// read a row at a time, eight at once into eight partial sums, so wider levels do the
+// same float operations in the same order and every level gives the same sums.
+void SumNeighboursScalar(const NeighbourGrid& grid, size_t begin, size_t end, float separation, NeighbourSums* out) {
+    const float* xs = grid.X();
+    const float* zs = grid.Z();
+    float separationSq = separation * separation;
+    float rangeSq = 4.0f * separationSq;
+    float invSeparationSq = 1.0f / separationSq;
+    unsigned int rowBegin[3], rowEnd[3];
+    for (size_t e = begin; e < end; e++) {
+        float x = xs[e], z = zs[e];
+        NeighbourLanes lanes;
+        int rows = grid.NeighbourRows(e, rowBegin, rowEnd);
+        for (int r = 0; r < rows; r++) {
+            for (unsigned int k = rowBegin[r]; k < rowEnd[r]; k++) {
+                int j = (int)((k - rowBegin[r]) % STEER_LANES);
+                float dx = x - xs[k], dz = z - zs[k];
+                float dSq = dx * dx + dz * dz;
+                bool present = dSq > 0.0f;
+                float push = present && dSq < separationSq ? (1.0f / std::max(dSq, 1e-6f) - invSeparationSq) * separation : 0.0f;
+                bool inRange = present && dSq < rangeSq;
+                lanes.separationX[j] += dx * push;
+                lanes.separationZ[j] += dz * push;
+                lanes.centerX[j] += inRange ? xs[k] : 0.0f;
+                lanes.centerZ[j] += inRange ? zs[k] : 0.0f;
+                lanes.count[j] += inRange ? 1.0f : 0.0f;
+            }
+        }
+        out[e] = ReduceNeighbourLanes(lanes);
+    }
+}
+
+#ifdef SIMD_X86
+void SumNeighboursSSE2(const NeighbourGrid& grid, size_t begin, size_t end, float separation, NeighbourSums* out) {
+    const float* xs = grid.X();
+    const float* zs = grid.Z();
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), tiny = _mm_set1_ps(1e-6f);
+    const __m128 separationV = _mm_set1_ps(separation);
+    const __m128 separationSq = _mm_set1_ps(separation * separation);
+    const __m128 rangeSq = _mm_set1_ps(4.0f * (separation * separation));
+    const __m128 invSeparationSq = _mm_set1_ps(1.0f / (separation * separation));
+    const __m128 laneLo = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), laneHi = _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f);
+    unsigned int rowBegin[3], rowEnd[3];
+    for (size_t e = begin; e < end; e++) {
+        __m128 x = _mm_set1_ps(xs[e]), z = _mm_set1_ps(zs[e]);
+        // Lanes 0-3 and 4-7
+        __m128 sepX[2] = { zero, zero }, sepZ[2] = { zero, zero };
+        __m128 cenX[2] = { zero, zero }, cenZ[2] = { zero, zero }, cnt[2] = { zero, zero };
+        int rows = grid.NeighbourRows(e, rowBegin, rowEnd);
+        for (int r = 0; r < rows; r++) {
+            for (unsigned int k = rowBegin[r]; k < rowEnd[r]; k += STEER_LANES) {
+                __m128 left = _mm_set1_ps((float)(rowEnd[r] - k));
+                for (int h = 0; h < 2; h++) {
+                    __m128 nx = _mm_loadu_ps(xs + k + 4 * h), nz = _mm_loadu_ps(zs + k + 4 * h);
+                    __m128 valid = _mm_cmplt_ps(h == 0 ? laneLo : laneHi, left);
+                    __m128 dx = _mm_sub_ps(x, nx), dz = _mm_sub_ps(z, nz);
+                    __m128 dSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+                    __m128 present = _mm_and_ps(valid, _mm_cmpgt_ps(dSq, zero));
+                    __m128 push = _mm_mul_ps(_mm_sub_ps(_mm_div_ps(one, _mm_max_ps(dSq, tiny)), invSeparationSq), separationV);
+                    push = _mm_and_ps(_mm_and_ps(present, _mm_cmplt_ps(dSq, separationSq)), push);
+                    __m128 inRange = _mm_and_ps(present, _mm_cmplt_ps(dSq, rangeSq));
+                    sepX[h] = _mm_add_ps(sepX[h], _mm_mul_ps(dx, push));
+                    sepZ[h] = _mm_add_ps(sepZ[h], _mm_mul_ps(dz, push));
+                    cenX[h] = _mm_add_ps(cenX[h], _mm_and_ps(inRange, nx));
+                    cenZ[h] = _mm_add_ps(cenZ[h], _mm_and_ps(inRange, nz));
+                    cnt[h] = _mm_add_ps(cnt[h], _mm_and_ps(inRange, one));
+                }
+            }
+        }
+        NeighbourLanes lanes;
+        for (int h = 0; h < 2; h++) {
+            _mm_storeu_ps(lanes.separationX + 4 * h, sepX[h]);
+            _mm_storeu_ps(lanes.separationZ + 4 * h, sepZ[h]);
+            _mm_storeu_ps(lanes.centerX + 4 * h, cenX[h]);
+            _mm_storeu_ps(lanes.centerZ + 4 * h, cenZ[h]);
+            _mm_storeu_ps(lanes.count + 4 * h, cnt[h]);
+        }
+        out[e] = ReduceNeighbourLanes(lanes);
+    }
+}
+
+SIMD_TARGET_AVX2
+void SumNeighboursAVX2(const NeighbourGrid& grid, size_t begin, size_t end, float separation, NeighbourSums* out) {
+    const float* xs = grid.X();
+    const float* zs = grid.Z();
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f), tiny = _mm256_set1_ps(1e-6f);
+    const __m256 separationV = _mm256_set1_ps(separation);
+    const __m256 separationSq = _mm256_set1_ps(separation * separation);
+    const __m256 rangeSq = _mm256_set1_ps(4.0f * (separation * separation));
+    const __m256 invSeparationSq = _mm256_set1_ps(1.0f / (separation * separation));
+    const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    unsigned int rowBegin[3], rowEnd[3];
+    for (size_t e = begin; e < end; e++) {
+        __m256 x = _mm256_set1_ps(xs[e]), z = _mm256_set1_ps(zs[e]);
+        __m256 sepX = zero, sepZ = zero, cenX = zero, cenZ = zero, cnt = zero;
+        int rows = grid.NeighbourRows(e, rowBegin, rowEnd);
+        for (int r = 0; r < rows; r++) {
+            for (unsigned int k = rowBegin[r]; k < rowEnd[r]; k += STEER_LANES) {
+                __m256 nx = _mm256_loadu_ps(xs + k), nz = _mm256_loadu_ps(zs + k);
+                __m256 valid = _mm256_cmp_ps(lane, _mm256_set1_ps((float)(rowEnd[r] - k)), _CMP_LT_OQ);
+                __m256 dx = _mm256_sub_ps(x, nx), dz = _mm256_sub_ps(z, nz);
+                __m256 dSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz));
+                __m256 present = _mm256_and_ps(valid, _mm256_cmp_ps(dSq, zero, _CMP_GT_OQ));
+                __m256 push = _mm256_mul_ps(_mm256_sub_ps(_mm256_div_ps(one, _mm256_max_ps(dSq, tiny)), invSeparationSq), separationV);
+                push = _mm256_and_ps(_mm256_and_ps(present, _mm256_cmp_ps(dSq, separationSq, _CMP_LT_OQ)), push);
+                __m256 inRange = _mm256_and_ps(present, _mm256_cmp_ps(dSq, rangeSq, _CMP_LT_OQ));
+                sepX = _mm256_add_ps(sepX, _mm256_mul_ps(dx, push));
+                sepZ = _mm256_add_ps(sepZ, _mm256_mul_ps(dz, push));
+                cenX = _mm256_add_ps(cenX, _mm256_and_ps(inRange, nx));
+                cenZ = _mm256_add_ps(cenZ, _mm256_and_ps(inRange, nz));
+                cnt = _mm256_add_ps(cnt, _mm256_and_ps(inRange, one));
+            }
+        }
+        NeighbourLanes lanes;
+        _mm256_storeu_ps(lanes.separationX, sepX);
+        _mm256_storeu_ps(lanes.separationZ, sepZ);
+        _mm256_storeu_ps(lanes.centerX, cenX);
+        _mm256_storeu_ps(lanes.centerZ, cenZ);
+        _mm256_storeu_ps(lanes.count, cnt);
+        out[e] = ReduceNeighbourLanes(lanes);
+    }
+}
+#endif
+
+void SumNeighbours(const NeighbourGrid& grid, size_t begin, size_t end, float separation, NeighbourSums* out) {
+#ifdef SIMD_X86
+    switch (GetSimdLevel()) {
+    case SIMD_AVX2:
+        SumNeighboursAVX2(grid, begin, end, separation, out);
+        return;
+    case SIMD_SSE2:
+        SumNeighboursSSE2(grid, begin, end, separation, out);
+        return;
+    default:
+        break;
+    }
+#endif
+    SumNeighboursScalar(grid, begin, end, separation, out);
+}
+
+#endif // !STEERING_H
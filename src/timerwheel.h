@@ -0,0 +1,223 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+using namespace std;
+
+// Timers count whole wheel ticks of a millisecond. Systems keep their clock in seconds and
+// convert: the current time rounds down and due times round up, so nothing fires early.
+const double TIMER_TICKS_PER_SECOND = 1000.0;
+
+inline unsigned long long TimerNow(double seconds) {
+    return (unsigned long long)floor(seconds * TIMER_TICKS_PER_SECOND);
+}
+
+inline unsigned long long TimerDue(double seconds) {
+    return (unsigned long long)ceil(seconds * TIMER_TICKS_PER_SECOND);
+}
+
+struct TimerHandle {
+    unsigned int index;
+    unsigned int generation;
+
+    TimerHandle() : index(0xFFFFFFFFu), generation(0) {}
+    TimerHandle(unsigned int index, unsigned int generation) : index(index), generation(generation) {}
+    bool IsValid() const { return index != 0xFFFFFFFFu; }
+};
+
+// Hierarchical timing wheel (Varghese & Lauck). Four levels of 256 slots: level 0 holds
+// timers due within the current 256 ticks, one slot per tick; each higher level covers
+// 256 times the span of the one below and is cascaded down as time reaches it. Timers
+// further out than 2^32 ticks wait in an overflow list. Advancing costs one slot visit
+// per tick passed plus the timers that fire or cascade, however many are pending.
+//
+// Timers fire in due order, ties in the order they were scheduled, so runs repeat exactly.
+template <typename T>
+class TimerWheel {
+private:
+    static const int LEVEL_BITS = 8;
+    static const int SLOTS = 1 << LEVEL_BITS;
+    static const int LEVELS = 4;
+
+    struct Node {
+        unsigned long long due;
+        unsigned long long sequence;    // Schedule order, breaks ties between equal due times
+        T payload;
+        unsigned int generation;
+        bool live;                      // False once cancelled or fired
+    };
+    struct Expired {
+        unsigned long long due;
+        unsigned long long sequence;
+        int node;
+
+        bool operator<(const Expired& other) const {
+            return due != other.due ? due < other.due : sequence < other.sequence;
+        }
+    };
+
+    vector<Node> nodes;
+    vector<int> freeNodes;
+    vector<int> slots[LEVELS][SLOTS];
+    vector<int> overflow;               // Due beyond the top level's reach
+    vector<Expired> ready;              // Due by now, fired by the current or next Advance
+    vector<Expired> firing;             // Scratch for Advance
+    vector<int> cascading;              // Scratch for Cascade
+    unsigned long long now;             // Every timer due at or before this has been collected
+    unsigned long long nextSequence;
+    size_t count;
+
+public:
+    // Every slot gets its storage up front. Sparse wheels would otherwise touch new slots
+    // for hours, which looks like a slow leak; now storage only grows to the busiest
+    // moment's size.
+    TimerWheel(unsigned long long start = 0) : now(start), nextSequence(0), count(0) {
+        for (int level = 0; level < LEVELS; level++) {
+            for (int slot = 0; slot < SLOTS; slot++) {
+                slots[level][slot].reserve(1);
+            }
+        }
+        overflow.reserve(1);
+        cascading.reserve(1);
+    }
+
+    // Fire payload once the wheel reaches due (already-passed times fire on the next Advance)
+    TimerHandle Schedule(unsigned long long due, const T& payload) {
+        int index;
+        if (!freeNodes.empty()) {
+            index = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        else {
+            index = (int)nodes.size();
+            nodes.push_back(Node());
+            nodes[index].generation = 0;
+        }
+        Node& node = nodes[index];
+        node.due = due;
+        node.sequence = nextSequence++;
+        node.payload = payload;
+        node.live = true;
+        count++;
+        Place(index);
+        return TimerHandle((unsigned int)index, node.generation);
+    }
+
+    // Returns false if the timer already fired or was cancelled
+    bool Cancel(TimerHandle handle) {
+        if (!IsPending(handle))
+            return false;
+        // Left in its slot and dropped when the wheel gets there
+        nodes[handle.index].live = false;
+        count--;
+        return true;
+    }
+
+    bool IsPending(TimerHandle handle) const {
+        return handle.index < nodes.size() && nodes[handle.index].generation == handle.generation
+            && nodes[handle.index].live;
+    }
+
+    // Move time forward to `to` and call onExpire(payload, due) for every timer due by
+    // then. Callbacks may schedule more timers; ones already due fire in this call too.
+    template <typename F>
+    void Advance(unsigned long long to, F onExpire) {
+        while (now < to) {
+            now++;
+            // Bring down the levels whose span starts now, top level first
+            if ((now & ((1ull << (LEVEL_BITS * LEVELS)) - 1)) == 0)
+                Cascade(overflow);
+            for (int level = LEVELS - 1; level > 0; level--) {
+                if ((now & ((1ull << (LEVEL_BITS * level)) - 1)) == 0)
+                    Cascade(slots[level][(now >> (LEVEL_BITS * level)) & (SLOTS - 1)]);
+            }
+            Collect(slots[0][now & (SLOTS - 1)]);
+        }
+        while (!ready.empty()) {
+            firing.swap(ready);
+            sort(firing.begin(), firing.end());
+            for (size_t i = 0; i < firing.size(); i++) {
+                Node& node = nodes[firing[i].node];
+                if (!node.live) {
+                    Free(firing[i].node);   // Cancelled after it came due
+                    continue;
+                }
+                T payload = node.payload;
+                Release(firing[i].node);
+                onExpire(payload, firing[i].due);
+            }
+            firing.clear();
+        }
+    }
+
+    unsigned long long Now() const {
+        return now;
+    }
+
+    // Timers waiting to fire
+    size_t Size() const {
+        return count;
+    }
+
+private:
+    // File a live node by how far off it is; only its own slot is ever touched again
+    void Place(int index) {
+        unsigned long long due = nodes[index].due;
+        if (due <= now) {
+            Expired expired = { due, nodes[index].sequence, index };
+            ready.push_back(expired);
+            return;
+        }
+        for (int level = 0; level < LEVELS; level++) {
+            int shift = LEVEL_BITS * (level + 1);
+            // Same span of this level as now: it will be reached without cascading past it
+            if ((due >> shift) == (now >> shift)) {
+                slots[level][(due >> (LEVEL_BITS * level)) & (SLOTS - 1)].push_back(index);
+                return;
+            }
+        }
+        overflow.push_back(index);
+    }
+
+    void Cascade(vector<int>& slot) {
+        if (slot.empty())
+            return;
+        cascading.swap(slot);
+        for (size_t i = 0; i < cascading.size(); i++) {
+            if (nodes[cascading[i]].live)
+                Place(cascading[i]);
+            else
+                Free(cascading[i]);
+        }
+        cascading.clear();
+    }
+
+    void Collect(vector<int>& slot) {
+        for (size_t i = 0; i < slot.size(); i++) {
+            int index = slot[i];
+            if (!nodes[index].live) {
+                Free(index);
+                continue;
+            }
+            Expired expired = { nodes[index].due, nodes[index].sequence, index };
+            ready.push_back(expired);
+        }
+        slot.clear();
+    }
+
+    // A fired timer
+    void Release(int index) {
+        nodes[index].live = false;
+        count--;
+        Free(index);
+    }
+
+    void Free(int index) {
+        nodes[index].generation++;
+        freeNodes.push_back(index);
+    }
+};
+
+#endif // !TIMERWHEEL_H
@@ -4,6 +4,7 @@
 #include <irrklang/irrKlang.h>
 using namespace irrklang;
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <iostream>
 #include <vector>
 #include <glm/glm.hpp>
@@ -11,28 +12,38 @@ using namespace irrklang;
 
 #include "place.h"
 #include "player.h"
-#include "camera.h"
-#include "ballmanager.h"
-#include "enemy.h"
+#include "inputreplay.h"
+#include "inputstate.h"
+#include "simulation.h"
+#include "ballrenderer.h"
+#include "enemyrenderer.h"
 #include "skybox.h"
-#include "healthpackmanager.h"
+#include "healthpackrenderer.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
 ISoundEngine* gangguan = createIrrKlangDevice();
+ISoundEngine* man = createIrrKlangDevice();
+ISoundEngine* xuebao = createIrrKlangDevice();
+int mancount = 0;
 
 class World {
 private:
     GLFWwindow* window;
     glm::vec2 windowSize;
 
+    Simulation* sim; // Game logic, rendered below
+    Camera* renderCamera;   // View drawn this frame, between the last two simulated ones
+    Camera previousCamera;  // Simulated camera before the latest tick
+    float tickLength;       // Length of the latest tick
+    bool fireHeld;          // Fire input of the latest tick, for the gun recoil
+
     Place* place;
     Player* player;
-    Camera* camera;
-    BallManager* ball;
-    Enemy* enemy;
+    BallRenderer* ball;
+    EnemyRenderer* enemy;
     Skybox* skybox; // Skybox for rendering dynamic sky
-    HealthPackManager* healthPacks;
+    HealthPackRenderer* healthPacks;
 
     GLuint depthMap;
     GLuint depthMapFBO;
@@ -41,12 +52,17 @@ private:
     TextRenderer* textRenderer;
     glm::mat4 lightSpaceMatrix;
 
-    int playerHealth;
-    int maxPlayerHealth;
-    bool gameOver;
+    // Cursor position last frame, turned into mouse deltas for the simulation
+    double mouseX;
+    double mouseY;
+    bool firstMouse;
+
+    // Optional input recording / playback; playback replaces GLFW input
+    InputRecorder* recorder;
+    InputReplay* replay;
+    bool replayFinished;
 
     // Day-night cycle variables
-    float gameTime; // Tracks game time for day-night cycle
     glm::vec3 lightDir; // Light direction (simulates sun/moon)
     glm::vec3 lightColor; // Light color (changes with time)
     float ambientStrength; // Ambient light strength
@@ -73,14 +89,11 @@ public:
         stbi_write_png(filename.c_str(), width, height, 3, flipped.data(), width * 3);
     }
 
-    World(GLFWwindow* window, glm::vec2 windowSize) : gameTime(0.0f) {
+    World(GLFWwindow* window, glm::vec2 windowSize, unsigned long long seed, const SimConfig& config = SimConfig()) : tickLength(0.0f), fireHeld(false),
+        mouseX(0.0), mouseY(0.0), firstMouse(true), recorder(NULL), replay(NULL), replayFinished(false) {
         this->window = window;
         this->windowSize = windowSize;
 
-        playerHealth = 10000000;
-        maxPlayerHealth = 10;
-        gameOver = false;
-
         // Initialize shaders
         textShader = new Shader("res/shader/text.vert", "res/shader/text.frag");
         textRenderer = new TextRenderer("res/font/msyh.ttf", textShader->GetProgram());
@@ -99,12 +112,16 @@ public:
         lightSpaceMatrix = lightProjection * lightView;
 
         // Initialize game objects
-        camera = new Camera(window);
+        sim = new Simulation(seed, config);
+        previousCamera = *sim->GetCamera();
+        renderCamera = new Camera(previousCamera);
+        const Camera* camera = renderCamera;
         place = new Place(windowSize, camera);
         player = new Player(windowSize, camera);
-        ball = new BallManager(windowSize, camera);
-        enemy = new Enemy(windowSize, camera, this->lightSpaceMatrix);
-        healthPacks = new HealthPackManager(windowSize, camera);
+        ball = new BallRenderer(windowSize, camera, sim->GetBalls());
+        enemy = new EnemyRenderer(windowSize, camera, this->lightSpaceMatrix, sim->GetEnemies());
+        sim->SetEnemyHitCapsule(enemy->GetHitCapsule()); // Shots hit what is drawn
+        healthPacks = new HealthPackRenderer(windowSize, camera, sim->GetHealthPacks());
         skybox = new Skybox();
 
         // Initialize shadow map framebuffer
@@ -132,11 +149,12 @@ public:
     ~World() {
         delete place;
         delete player;
-        delete camera;
         delete ball;
         delete enemy;
         delete healthPacks;
         delete skybox;
+        delete sim;
+        delete renderCamera;
         delete simpleDepthShader;
         delete textShader;
         glDeleteTextures(1, &depthMap);
@@ -144,10 +162,36 @@ public:
     }
 
     void Update(float deltaTime) {
+        InputState input;
+        if (replay) {
+            // Recorded tick length and spawn limits too, so playback matches whatever the
+            // frame rate
+            DirectorLimits limits = sim->GetLimits();
+            if (!replay->Next(input, deltaTime, limits)) {
+                replayFinished = true;
+                return;
+            }
+            sim->SetLimits(limits);
+        }
+        else {
+            input = PollInput();
+        }
+        Advance(input, deltaTime);
+        if (recorder)
+            recorder->Record(input, deltaTime, sim->GetLimits());
+    }
+
+    // Step the game with the given input and update everything drawn from it
+    void Advance(const InputState& input, float deltaTime) {
+        // Keep the state before the tick, Render blends from it
+        previousCamera = *sim->GetCamera();
+        enemy->SaveState();
+        const vector<GameEvent>& events = sim->Step(input, deltaTime);
+        tickLength = deltaTime;
+        fireHeld = input.fire;
 
         // Update day-night cycle
-        gameTime += deltaTime;
-        float cycleTime = fmod(gameTime, 60.0f); // 60-second cycle
+        float cycleTime = (float)fmod(sim->GetGameTime(), 60.0); // 60-second cycle
         float t = 0.5f * (1.0f - cos(cycleTime * glm::pi<float>() / 30.0f)); // Smooth curve
         if (cycleTime < 30.0f) { // Day: 0-30 seconds
             dayNightCycle = (t * cycleTime / 30.0f) * 0.5f;
@@ -180,46 +224,25 @@ public:
         glm::mat4 lightView = glm::lookAt(lightPos, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         lightSpaceMatrix = lightProjection * lightView;
 
-        // Update game objects
-        camera->Update(deltaTime);
-        place->Update();
-        std::vector<glm::vec3> currentEnemyPositions = enemy->GetEnemyPositions();
-        ball->UpdateEnemyPositions(currentEnemyPositions);
-        ball->Update(deltaTime, GetScore());
-        bool playerIsShooting = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
-        enemy->Update(camera->GetPosition(), camera->GetFront(), playerIsShooting, deltaTime);
-        player->Update(deltaTime, playerIsShooting);
-        healthPacks->Update(deltaTime);
-
-        // Handle health pack pickup (E key)
-        static bool e_key_was_pressed = false;
-        bool e_key_currently_pressed = (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS);
-        if (e_key_currently_pressed && !e_key_was_pressed) {
-            if (healthPacks->TryPickupHealthPack(camera->GetPosition())) {
-                if (playerHealth < maxPlayerHealth) {
-                    playerHealth++;
-                    std::cout << "Health restored! Current health: " << playerHealth << "/" << maxPlayerHealth << std::endl;
-                }
-                else {
-                    std::cout << "Health is already full!" << std::endl;
-                }
+        // Play sounds for what happened this tick
+        for (size_t i = 0; i < events.size(); i++) {
+            if (events[i].type == GAME_EVENT_ENEMY_KILLED) {
+                if(mancount%2==0)
+                man->play2D("res/audio/man0.mp3", GL_FALSE);
+                else
+                man->play2D("res/audio/man1.mp3", GL_FALSE);
+                mancount++;
             }
-        }
-        e_key_was_pressed = e_key_currently_pressed;
-
-        // Handle bullet collision with player
-        if (ball->CheckBulletHitPlayer()) {
-            playerHealth--;
-            gangguan->play2D("res/audio/gangguan.mp3", GL_FALSE);
-            std::cout << "Player hit! Remaining health: " << playerHealth << "/" << maxPlayerHealth << std::endl;
-            if (playerHealth <= 0) {
-                gameOver = true;
-                std::cout << "Game Over! Player died!" << std::endl;
+            else if (events[i].type == GAME_EVENT_HEALTH_PACK_PICKED) {
+                xuebao->play2D("res/audio/xuebao.mp3", GL_FALSE);
+            }
+            else if (events[i].type == GAME_EVENT_PLAYER_HIT) {
+                gangguan->play2D("res/audio/gangguan.mp3", GL_FALSE);
             }
         }
         // 在Update函数内合适位置添加
         static bool i_key_was_pressed = false;
-        bool i_key_currently_pressed = (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS);
+        bool i_key_currently_pressed = input.screenshot;
         if (i_key_currently_pressed && !i_key_was_pressed) {
             // 确保out目录存在
             system("mkdir -p out");
@@ -232,14 +255,27 @@ public:
 
     }
 
-    void Render() {
-
+    // Draw the game alpha of the way from the previous tick to the latest one (1: latest).
+    // The CPU time it takes counts against the simulation's frame budget.
+    void Render(float alpha = 1.0f) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        // Update render state of game objects
+        renderCamera->Interpolate(previousCamera, *sim->GetCamera(), alpha);
+        ball->SetInterpolation(alpha, tickLength);
+        enemy->SetInterpolation(alpha);
+        healthPacks->SetInterpolation(alpha, tickLength);
+        place->Update();
+        ball->Update();
+        enemy->Update();
+        player->Update(tickLength, fireHeld);
+        healthPacks->Update();
 
         // Render shadow map
         RenderDepth();
 
         // Render skybox
         glDepthMask(GL_FALSE);
+        const Camera* camera = renderCamera;
         skybox->Render(camera->GetViewMatrix(), glm::perspective(glm::radians(camera->GetZoom()), windowSize.x / windowSize.y, 0.1f, 500.0f), dayNightCycle);
         glDepthMask(GL_TRUE);
 
@@ -257,7 +293,7 @@ public:
         std::wstring healthStr = L"血量: " + std::to_wstring(GetPlayerHealth()) + L"/" + std::to_wstring(GetMaxPlayerHealth());
         textRenderer->RenderText(scoreStr, 25.0f, windowSize.y - 50.0f, 1.0f, glm::vec3(1, 1, 0), windowSize.x, windowSize.y);
         textRenderer->RenderText(healthStr, 25.0f, windowSize.y - 100.0f, 1.0f, glm::vec3(0, 1, 0), windowSize.x, windowSize.y);
-        if (gameOver) {
+        if (sim->IsOver()) {
             std::wstring line1 = L"游戏结束";
             std::wstring line2 = L"按q键退出";
             float scale = 2.5f;
@@ -269,17 +305,50 @@ public:
             float y = windowSize.y / 2.0f;
             textRenderer->RenderText(line2, x1 - 60, y - 40.0f * scale, scale, glm::vec3(1, 1, 0), windowSize.x, windowSize.y); // 黄色
             textRenderer->RenderText(line1, x2, y + 40.0f * scale, scale, glm::vec3(0.6f, 0, 1), windowSize.x, windowSize.y); // 紫色
-            return;
         }
+        sim->ReportRenderSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
     }
 
-    GLuint GetScore() { return enemy->GetKillCount(); }
-    bool IsOver() { return gameOver; }
-    int GetPlayerHealth() const { return playerHealth; }
-    int GetMaxPlayerHealth() const { return maxPlayerHealth; }
-    size_t GetActiveHealthPackCount() const { return healthPacks->GetActiveHealthPackCount(); }
+    GLuint GetScore() { return sim->GetScore(); }
+    bool IsOver() { return sim->IsOver(); }
+    bool IsReplayFinished() { return replayFinished; }
+    Simulation* GetSimulation() { return sim; }
+
+    // Record every tick's input; the recorder must have been opened with this world's seed
+    void SetRecorder(InputRecorder* recorder) { this->recorder = recorder; }
+    // Drive the game from a recording instead of GLFW; the world must use its seed
+    void SetReplay(InputReplay* replay) { this->replay = replay; }
+    int GetPlayerHealth() const { return sim->GetPlayerHealth(); }
+    int GetMaxPlayerHealth() const { return sim->GetMaxPlayerHealth(); }
+    size_t GetActiveHealthPackCount() const { return sim->GetActiveHealthPackCount(); }
 
 private:
+    // Read keyboard and mouse into the snapshot the simulation consumes
+    InputState PollInput() {
+        InputState input;
+        input.forward = (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS);
+        input.back = (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS);
+        input.left = (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS);
+        input.right = (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS);
+        input.jump = (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS);
+        input.fire = (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS);
+        input.pickup = (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS);
+        input.screenshot = (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS);
+
+        double newMouseX, newMouseY;
+        glfwGetCursorPos(window, &newMouseX, &newMouseY);
+        if (firstMouse) {
+            mouseX = newMouseX;
+            mouseY = newMouseY;
+            firstMouse = false;
+        }
+        input.mouseDX = (float)(newMouseX - mouseX);
+        input.mouseDY = (float)(newMouseY - mouseY);
+        mouseX = newMouseX;
+        mouseY = newMouseY;
+        return input;
+    }
+
     void RenderDepth() {
         glEnable(GL_DEPTH_TEST);
         glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);